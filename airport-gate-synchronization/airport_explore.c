@@ -0,0 +1,746 @@
+/*
+ * File: airport_explore.c
+ * Deterministic schedule exploration for the gate-assignment logic
+ *
+ * Runs simulated flights as coroutines on a single OS thread under a
+ * controlled scheduler. Every shared access and every lock/semaphore
+ * operation is a yield point, so the scheduler alone decides the
+ * interleaving and any run can be replayed exactly.
+ *
+ * Three kernels:
+ *   unsync:    find_gate_unsafe / release_gate_unsafe, a step-for-step copy
+ *              of airport_unsync.c (keep it in line with that file)
+ *   sync:      the real airport_sync.c, included below. Its YIELD() hooks
+ *              and its lock and semaphore calls become yield points; flights
+ *              run operate_flight and one more task, the clock, runs
+ *              advance_clock so timer auto-release and cleaning interleave
+ *              with them.
+ *   terminals: the same with init_terminals, so flights take gates through
+ *              assign_gate_partitioned and the terminal pools (-t)
+ *
+ * Invariants checked on every run:
+ * 1. No gate is assigned to a flight while another flight holds it
+ * 2. International flights only get international gates unless emergency
+ * 3. served + diverted == total flights, emergencies <= served
+ * 4. Every gate is released at the end, and no deadlock
+ *
+ * A failing schedule is minimized to the fewest forced context switches
+ * that still break an invariant, then printed as a replayable string.
+ *
+ * Build: gcc -pthread airport_explore.c timer_wheel.c flight_schedule.c handoff.c \
+ *            slab.c ../coro/coro.c -o airport_explore
+ * Usage: ./airport_explore [-m unsync|sync|terminals] [-n flights] [-s seed]
+ *                          [-i runs] [-p preemption_bound] [-r schedule]
+ *   default: random exploration of every kernel from the seed
+ *   -p N:    systematic exploration of every schedule with <= N preemptions
+ *   -r S:    replay one schedule ("step:task,step:task,...") verbosely;
+ *            tasks are the flights 1..n, and n+1 is the clock (sync only)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ucontext.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#define UNSYNC_GATES 2
+#define MAX_FLIGHTS 8
+#define MAX_TASKS (MAX_FLIGHTS + 1) // the flights and the clock
+#define MAX_STEPS 4096
+#define STACK_SIZE (64 * 1024)
+
+typedef enum { UNSYNC, SYNC, SYNC_TERMINALS } Kernel;
+
+static const char* kernel_names[] = {"unsync", "sync", "terminals"};
+
+// ---------------------------------------------------------------------------
+// Controlled scheduler
+// ---------------------------------------------------------------------------
+
+typedef enum { TASK_RUNNABLE, TASK_DONE } TaskState;
+
+typedef struct {
+    ucontext_t ctx;
+    char* stack;
+    TaskState state;
+    pthread_mutex_t* wait_mutex; // blocked until free
+    const char* at;              // label of the yield point it is parked at
+    char name[16];
+} Task;
+
+// A forced context switch: at scheduling step `step`, run `task`
+typedef struct {
+    int step;
+    int task;
+} Preemption;
+
+typedef struct {
+    Preemption items[MAX_STEPS];
+    int count;
+} Schedule;
+
+typedef enum { PICK_REPLAY, PICK_RANDOM, PICK_SYSTEMATIC } PickMode;
+
+// One scheduling decision, kept for systematic backtracking
+typedef struct {
+    int options[MAX_TASKS];
+    int noptions;
+    int chosen;               // index into options
+    int default_index;        // index of the non-preempting choice
+    int preemptions;          // forced switches before this step
+} Step;
+
+static Task tasks[MAX_TASKS];
+static int ntasks;
+static int current;
+static ucontext_t scheduler_ctx;
+
+static PickMode pick_mode;
+static const Schedule* replay;    // PICK_REPLAY / prefix source
+static uint64_t rng_state;
+static Step steps[MAX_STEPS];
+static int nsteps;
+static int systematic_prefix;     // steps replayed verbatim from `steps`
+static bool verbose;
+
+static char violation[256];
+
+static void fail(const char* fmt, ...) {
+    va_list ap;
+    if (violation[0]) return; // keep the first one
+    va_start(ap, fmt);
+    vsnprintf(violation, sizeof(violation), fmt, ap);
+    va_end(ap);
+}
+
+static void yield_point(const char* label) {
+    tasks[current].at = label;
+    swapcontext(&tasks[current].ctx, &scheduler_ctx);
+}
+
+// The real primitives keep their own state. On one OS thread trylock never
+// blocks, so a task that would block parks on the mutex until a probe says
+// it is free. airport_sync.c only ever try-waits on its semaphores.
+static bool mutex_free(pthread_mutex_t* m) {
+    if (pthread_mutex_trylock(m) != 0) return false;
+    pthread_mutex_unlock(m);
+    return true;
+}
+
+static bool can_run(const Task* t) {
+    if (t->state != TASK_RUNNABLE) return false;
+    if (t->wait_mutex && !mutex_free(t->wait_mutex)) return false;
+    return true;
+}
+
+static int explore_mutex_lock(pthread_mutex_t* m, const char* label) {
+    yield_point(label);
+    while (pthread_mutex_trylock(m) != 0) {
+        tasks[current].wait_mutex = m;
+        yield_point(label);
+    }
+    return 0;
+}
+
+static int explore_mutex_unlock(pthread_mutex_t* m, const char* label) {
+    pthread_mutex_unlock(m);
+    yield_point(label);
+    return 0;
+}
+
+static int explore_sem_trywait(sem_t* s, const char* label) {
+    yield_point(label);
+    return sem_trywait(s);
+}
+
+static int explore_sem_post(sem_t* s, const char* label) {
+    sem_post(s);
+    yield_point(label);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Code under test: airport_sync.c with every lock operation a yield point
+// ---------------------------------------------------------------------------
+
+#define pthread_mutex_lock(m)   explore_mutex_lock((m), "lock " #m)
+#define pthread_mutex_unlock(m) explore_mutex_unlock((m), "unlock " #m)
+#define sem_trywait(s)          explore_sem_trywait((s), "sem_trywait " #s)
+#define sem_post(s)             explore_sem_post((s), "sem_post " #s)
+#define YIELD(label)            yield_point(label)
+#define AIRPORT_SYNC_NO_MAIN
+#include "airport_sync.c"
+#undef pthread_mutex_lock
+#undef pthread_mutex_unlock
+#undef sem_trywait
+#undef sem_post
+
+// Every shared read and write is preceded by a yield point
+#define LOAD(x) (yield_point("read " #x), (x))
+#define STORE(x, v) do { yield_point("write " #x); (x) = (v); } while (0)
+
+typedef struct {
+    int flight_id;
+    FlightType type;
+    bool is_emergency;
+    int arrival_time;
+    int turnaround_hours;
+} Flight;
+
+static Flight flights[MAX_FLIGHTS];
+static int nflights;
+static Kernel kernel;
+static int clock_hours;           // Ticks the clock task runs in the sync kernel
+
+// ---------------------------------------------------------------------------
+// Kernel: find_gate_unsafe / release_gate_unsafe (airport_unsync.c)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char* gate_name;
+    FlightType type;
+    GateStatus status;
+    int current_flight;
+    int occupied_until;
+    bool is_emergency;
+    int cleaning_time;
+} UnsyncGate;
+
+static UnsyncGate unsync_airport[UNSYNC_GATES];
+static int unsync_served;
+static int unsync_diverted;
+static int unsync_emergencies;
+static int unsync_time;
+
+static void init_unsync_airport(void) {
+    const char* names[UNSYNC_GATES] = {"A1", "B1"};
+    FlightType types[UNSYNC_GATES] = {DOMESTIC, INTERNATIONAL};
+    for (int i = 0; i < UNSYNC_GATES; i++) {
+        unsync_airport[i].gate_name = names[i];
+        unsync_airport[i].type = types[i];
+        unsync_airport[i].status = AVAILABLE;
+        unsync_airport[i].current_flight = -1;
+        unsync_airport[i].occupied_until = 0;
+        unsync_airport[i].is_emergency = false;
+        unsync_airport[i].cleaning_time = 1;
+    }
+    unsync_served = 0;
+    unsync_diverted = 0;
+    unsync_emergencies = 0;
+    unsync_time = 0;
+}
+
+static int find_gate_unsafe(const Flight* f) {
+    for (int i = 0; i < UNSYNC_GATES; i++) {
+        UnsyncGate* g = &unsync_airport[i];
+        bool gate_available = false;
+
+        if (LOAD(g->status) == AVAILABLE) {
+            if (f->type == DOMESTIC) {
+                gate_available = true;
+            } else {
+                gate_available = (g->type == INTERNATIONAL);
+            }
+            if (f->is_emergency && !gate_available) {
+                gate_available = true;
+            }
+        }
+
+        if (gate_available) {
+            yield_point("decision time (usleep)");
+
+            if (LOAD(g->occupied_until) > f->arrival_time) {
+                continue;
+            }
+
+            STORE(g->status, OCCUPIED);
+            STORE(g->current_flight, f->flight_id);
+            STORE(g->occupied_until, f->arrival_time + f->turnaround_hours + g->cleaning_time);
+            STORE(g->is_emergency, f->is_emergency);
+
+            int served = LOAD(unsync_served);
+            STORE(unsync_served, served + 1);
+            if (f->is_emergency) {
+                int handled = LOAD(unsync_emergencies);
+                STORE(unsync_emergencies, handled + 1);
+            }
+            return i;
+        }
+    }
+
+    int diverted = LOAD(unsync_diverted);
+    STORE(unsync_diverted, diverted + 1);
+    return -1;
+}
+
+static void release_gate_unsafe(int i, const Flight* f) {
+    UnsyncGate* g = &unsync_airport[i];
+    (void)f;
+    STORE(g->status, AVAILABLE);
+    STORE(g->current_flight, -1);
+    STORE(g->is_emergency, false);
+    STORE(g->occupied_until, LOAD(unsync_time) + g->cleaning_time);
+}
+
+// ---------------------------------------------------------------------------
+// Oracle
+// ---------------------------------------------------------------------------
+
+// Ghost state: the flight seen at each gate after the previous step. A gate
+// passes from one flight to another only through -1 (released).
+static int seen_flight[NUM_GATES];
+
+static void watch_gate(int i, const char* name, FlightType type, int flight_id) {
+    int prev = seen_flight[i];
+    seen_flight[i] = flight_id;
+    if (flight_id == -1 || flight_id == prev) return;
+
+    if (prev != -1) {
+        fail("gate %s double-assigned: FL%d while FL%d holds it", name, flight_id, prev);
+    }
+    const Flight* f = &flights[flight_id - 1];
+    if (f->type == INTERNATIONAL && type == DOMESTIC && !f->is_emergency) {
+        fail("gate %s: international FL%d at a domestic gate", name, flight_id);
+    }
+}
+
+static void watch_gates(void) {
+    if (kernel == UNSYNC) {
+        for (int i = 0; i < UNSYNC_GATES; i++) {
+            watch_gate(i, unsync_airport[i].gate_name, unsync_airport[i].type,
+                       unsync_airport[i].current_flight);
+        }
+    } else {
+        for (int i = 0; i < NUM_GATES; i++) {
+            watch_gate(i, airport[i].gate_name, airport[i].type, airport[i].current_flight);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scheduling
+// ---------------------------------------------------------------------------
+
+static uint64_t next_random(void) {
+    // xorshift64*: deterministic for a given seed
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ull;
+}
+
+// Chooses which runnable task goes next; default is to keep running the
+// current task, else the lowest runnable id
+static int pick(int step, int* runnable, int n) {
+    int def = 0;
+    for (int k = 0; k < n; k++) {
+        if (runnable[k] == current) def = k;
+    }
+
+    Step* s = &steps[step];
+    memcpy(s->options, runnable, sizeof(int) * n);
+    s->noptions = n;
+    s->default_index = def;
+    s->preemptions = step ? steps[step - 1].preemptions +
+                            (steps[step - 1].chosen != steps[step - 1].default_index) : 0;
+
+    int chosen = def;
+    if (pick_mode == PICK_RANDOM) {
+        chosen = (int)(next_random() % n);
+    } else if (pick_mode == PICK_SYSTEMATIC && step < systematic_prefix) {
+        chosen = s->chosen; // replay the prefix being explored
+    } else if (pick_mode == PICK_REPLAY && replay) {
+        for (int p = 0; p < replay->count; p++) {
+            if (replay->items[p].step != step) continue;
+            for (int k = 0; k < n; k++) {
+                if (runnable[k] == replay->items[p].task) chosen = k;
+            }
+        }
+    }
+    s->chosen = chosen;
+    return runnable[chosen];
+}
+
+static void run_scheduler(void) {
+    nsteps = 0;
+    current = 0;
+    for (;;) {
+        watch_gates();
+        if (violation[0]) return;
+
+        int runnable[MAX_TASKS];
+        int n = 0;
+        bool all_done = true;
+        for (int t = 0; t < ntasks; t++) {
+            if (tasks[t].state != TASK_DONE) all_done = false;
+            if (can_run(&tasks[t])) runnable[n++] = t;
+        }
+        if (all_done) return;
+        if (n == 0) {
+            fail("deadlock: no flight can make progress");
+            return;
+        }
+        if (nsteps == MAX_STEPS) {
+            fail("livelock: no completion after %d steps", MAX_STEPS);
+            return;
+        }
+
+        int next = pick(nsteps, runnable, n);
+        if (verbose && next != current && tasks[current].state != TASK_DONE) {
+            printf("  [step %d] switch %s -> %s (%s parked at: %s)\n",
+                   nsteps, tasks[current].name, tasks[next].name, tasks[current].name,
+                   tasks[current].at ? tasks[current].at : "start");
+        }
+        nsteps++;
+        current = next;
+        tasks[current].wait_mutex = NULL;
+        swapcontext(&scheduler_ctx, &tasks[current].ctx);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Runs
+// ---------------------------------------------------------------------------
+
+static void flight_task(void) {
+    const Flight* f = &flights[current];
+
+    if (kernel == UNSYNC) {
+        int gate = find_gate_unsafe(f);
+        if (gate != -1) {
+            yield_point("turnaround");
+            release_gate_unsafe(gate, f);
+        }
+    } else {
+        // No arrival or turnaround delay: the scheduler decides the timing
+        operate_flight(f->flight_id, f->type, f->is_emergency,
+                       f->arrival_time, f->turnaround_hours, 0, 0, 0);
+    }
+    tasks[current].state = TASK_DONE;
+    // returning switches back to the scheduler through uc_link
+}
+
+// The time thread's work, one hour per advance_clock
+static void clock_task(void) {
+    for (int h = 0; h < clock_hours; h++) {
+        advance_clock();
+    }
+    tasks[current].state = TASK_DONE;
+}
+
+// Flights follow main(): alternate types, every 4th is an emergency
+static void init_flights(int n) {
+    nflights = n;
+    for (int i = 0; i < n; i++) {
+        flights[i].flight_id = i + 1;
+        flights[i].type = (i % 2) ? INTERNATIONAL : DOMESTIC;
+        flights[i].is_emergency = (i % 4) == 0 && i > 0;
+        flights[i].arrival_time = 1 + i % 3;
+        flights[i].turnaround_hours = 1 + i % 5;
+    }
+    // Long enough for every gate's auto-release and cleaning to fire
+    clock_hours = 0;
+    for (int i = 0; i < n; i++) {
+        int until = flights[i].arrival_time + flights[i].turnaround_hours + 1;
+        if (until > clock_hours) clock_hours = until;
+    }
+}
+
+static void check_final_state(void) {
+    int served = kernel == UNSYNC ? unsync_served : total_flights_served;
+    int diverted = kernel == UNSYNC ? unsync_diverted : flights_diverted;
+    int emergencies = kernel == UNSYNC ? unsync_emergencies : emergency_flights_handled;
+
+    watch_gates();
+    if (violation[0]) return;
+    if (served + diverted != nflights) {
+        fail("statistics: served + diverted = %d, expected %d", served + diverted, nflights);
+    } else if (emergencies > served) {
+        fail("statistics: %d emergencies handled but only %d served", emergencies, served);
+    }
+    for (int i = 0; i < (kernel == UNSYNC ? UNSYNC_GATES : NUM_GATES); i++) {
+        const char* name = kernel == UNSYNC ? unsync_airport[i].gate_name : airport[i].gate_name;
+        bool occupied = kernel == UNSYNC ? unsync_airport[i].status == OCCUPIED
+                                         : airport[i].status == OCCUPIED;
+        if (occupied) {
+            fail("gate %s still occupied by FL%d at the end", name, seen_flight[i]);
+        }
+    }
+}
+
+// Executes one complete run; true if every invariant held
+static bool run_once(void) {
+    violation[0] = '\0';
+    for (int i = 0; i < NUM_GATES; i++) {
+        seen_flight[i] = -1;
+    }
+    if (kernel == UNSYNC) {
+        init_unsync_airport();
+    } else {
+        init_airport_sync();
+        if (kernel == SYNC_TERMINALS) init_terminals();
+        verbose_log = false;
+    }
+
+    ntasks = kernel == UNSYNC ? nflights : nflights + 1;
+    for (int t = 0; t < ntasks; t++) {
+        bool is_clock = t == nflights;
+        getcontext(&tasks[t].ctx);
+        tasks[t].ctx.uc_stack.ss_sp = tasks[t].stack;
+        tasks[t].ctx.uc_stack.ss_size = STACK_SIZE;
+        tasks[t].ctx.uc_link = &scheduler_ctx;
+        makecontext(&tasks[t].ctx, is_clock ? clock_task : flight_task, 0);
+        tasks[t].state = TASK_RUNNABLE;
+        tasks[t].wait_mutex = NULL;
+        tasks[t].at = NULL;
+        if (is_clock) {
+            snprintf(tasks[t].name, sizeof(tasks[t].name), "clock");
+        } else {
+            snprintf(tasks[t].name, sizeof(tasks[t].name), "FL%d", t + 1);
+        }
+    }
+    run_scheduler();
+    if (!violation[0]) check_final_state();
+
+    // An abandoned run may leave locks held; they are destroyed regardless
+    if (kernel != UNSYNC) cleanup_airport_sync();
+    return violation[0] == '\0';
+}
+
+// The forced switches of the last run
+static void schedule_from_steps(Schedule* out) {
+    out->count = 0;
+    for (int k = 0; k < nsteps; k++) {
+        if (steps[k].chosen != steps[k].default_index) {
+            out->items[out->count].step = k;
+            out->items[out->count].task = steps[k].options[steps[k].chosen];
+            out->count++;
+        }
+    }
+}
+
+static bool replay_fails(const Schedule* s) {
+    pick_mode = PICK_REPLAY;
+    replay = s;
+    return !run_once();
+}
+
+// Same invariant broken: the message up to its first ':' matches
+static bool same_violation(const char* a, const char* b) {
+    size_t n = strcspn(a, ":");
+    return strncmp(a, b, n) == 0 && b[n] == a[n];
+}
+
+// Drops forced switches one at a time while the run still breaks the same
+// invariant, until none can be removed (1-minimal). Re-derives the schedule
+// after every success so step numbers stay aligned with what actually ran.
+static void minimize(Schedule* s, const char* target) {
+    bool shrunk = true;
+    while (shrunk) {
+        shrunk = false;
+        for (int p = 0; p < s->count; p++) {
+            Schedule trial;
+            trial.count = 0;
+            for (int q = 0; q < s->count; q++) {
+                if (q != p) trial.items[trial.count++] = s->items[q];
+            }
+            if (replay_fails(&trial) && same_violation(target, violation)) {
+                schedule_from_steps(s);
+                shrunk = true;
+                break;
+            }
+        }
+    }
+}
+
+static void print_schedule(const Schedule* s) {
+    if (s->count == 0) {
+        printf("(no forced switches)");
+    }
+    for (int p = 0; p < s->count; p++) {
+        printf("%s%d:%d", p ? "," : "", s->items[p].step, s->items[p].task + 1);
+    }
+    printf("\n");
+}
+
+static int parse_schedule(const char* text, Schedule* s) {
+    s->count = 0;
+    while (*text) {
+        int step, flight, used;
+        if (sscanf(text, "%d:%d%n", &step, &flight, &used) != 2 || flight < 1 ||
+            s->count == MAX_STEPS) {
+            return -1;
+        }
+        s->items[s->count].step = step;
+        s->items[s->count].task = flight - 1;
+        s->count++;
+        text += used;
+        if (*text == ',') text++;
+    }
+    return 0;
+}
+
+static void report_failure(void) {
+    Schedule s;
+    char first[256];
+    strcpy(first, violation);
+    schedule_from_steps(&s);
+    int before = s.count;
+    minimize(&s, first);
+
+    printf("  ⚠️  %s\n", first);
+    printf("  Minimized from %d to %d forced switches. Replay with -r ", before, s.count);
+    print_schedule(&s);
+
+    // Show the interleaving of the minimized schedule
+    verbose = true;
+    replay_fails(&s);
+    verbose = false;
+    printf("  -> %s\n", violation);
+}
+
+static int explore_random(uint64_t seed, int runs) {
+    for (int r = 0; r < runs; r++) {
+        pick_mode = PICK_RANDOM;
+        rng_state = (seed + r) * 0x9e3779b97f4a7c15ull | 1;
+        if (!run_once()) {
+            printf("  Violation on run %d (seed %llu)\n", r, (unsigned long long)(seed + r));
+            report_failure();
+            return 1;
+        }
+    }
+    printf("  ✓ %d random schedules, no invariant violated\n", runs);
+    return 0;
+}
+
+// Depth-first search over every schedule with at most `bound` forced switches
+static int explore_systematic(int bound, int max_runs) {
+    int runs = 0;
+    systematic_prefix = 0;
+    for (;;) {
+        pick_mode = PICK_SYSTEMATIC;
+        bool ok = run_once();
+        runs++;
+        if (!ok) {
+            printf("  Violation on schedule %d\n", runs);
+            report_failure();
+            return 1;
+        }
+        if (runs == max_runs) {
+            printf("  ✓ %d schedules (search cut off), no invariant violated\n", runs);
+            return 0;
+        }
+
+        // Deepest step with an untried alternative within the bound
+        int k = nsteps - 1;
+        for (; k >= 0; k--) {
+            Step* s = &steps[k];
+            int next = s->chosen + 1;
+            if (next == s->default_index) next++;
+            // Options are tried as: default first, then the rest in order
+            if (s->chosen == s->default_index) next = s->default_index == 0 ? 1 : 0;
+            if (next >= s->noptions) continue;
+            if (s->preemptions + 1 > bound) continue;
+            s->chosen = next;
+            break;
+        }
+        if (k < 0) break;
+        systematic_prefix = k + 1;
+    }
+    printf("  ✓ all %d schedules with <= %d preemptions, no invariant violated\n", runs, bound);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int explore_all = 1;
+    Kernel only = SYNC;
+    int n = 3;
+    uint64_t seed = 1;
+    int runs = 10000;
+    int bound = -1;
+    const char* replay_text = NULL;
+
+    for (int a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "-m") && a + 1 < argc) {
+            a++;
+            explore_all = 0;
+            only = strcmp(argv[a], "unsync") == 0    ? UNSYNC
+                 : strcmp(argv[a], "terminals") == 0 ? SYNC_TERMINALS
+                                                     : SYNC;
+        } else if (!strcmp(argv[a], "-n") && a + 1 < argc) {
+            n = atoi(argv[++a]);
+        } else if (!strcmp(argv[a], "-s") && a + 1 < argc) {
+            seed = strtoull(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "-i") && a + 1 < argc) {
+            runs = atoi(argv[++a]);
+        } else if (!strcmp(argv[a], "-p") && a + 1 < argc) {
+            bound = atoi(argv[++a]);
+        } else if (!strcmp(argv[a], "-r") && a + 1 < argc) {
+            replay_text = argv[++a];
+        } else {
+            printf("usage: %s [-m unsync|sync|terminals] [-n flights] [-s seed] [-i runs] "
+                   "[-p preemption_bound] [-r schedule]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (n < 1 || n > MAX_FLIGHTS) {
+        printf("flights must be between 1 and %d\n", MAX_FLIGHTS);
+        return 2;
+    }
+
+    for (int t = 0; t < MAX_TASKS; t++) {
+        tasks[t].stack = malloc(STACK_SIZE);
+        if (!tasks[t].stack) {
+            printf("Cannot allocate %d task stacks\n", MAX_TASKS);
+            return 2;
+        }
+    }
+    init_flights(n);
+
+    printf("===============================================\n");
+    printf("AIRPORT GATE ASSIGNMENT - SCHEDULE EXPLORATION\n");
+    printf("===============================================\n");
+    printf("Flights: %d\n", n);
+    printf("unsync gates: %d (A1: Domestic, B1: International)\n", UNSYNC_GATES);
+    printf("sync gates:   %d, as in airport_sync.c, and a clock running %d hours\n",
+           NUM_GATES, clock_hours);
+
+    if (replay_text) {
+        Schedule s;
+        if (parse_schedule(replay_text, &s) != 0) {
+            printf("bad schedule: %s\n", replay_text);
+            return 2;
+        }
+        kernel = explore_all ? UNSYNC : only;
+        printf("\nReplaying on %s kernel:\n", kernel_names[kernel]);
+        verbose = true;
+        bool failed = replay_fails(&s);
+        printf(failed ? "  ⚠️  %s\n" : "  ✓ no invariant violated%s\n", violation);
+        return failed ? 1 : 0;
+    }
+
+    int sync_failed = 0;
+    for (int k = UNSYNC; k <= SYNC_TERMINALS; k++) {
+        if (!explore_all && k != (int)only) continue;
+        kernel = k;
+        printf("\n%s kernel (%s):\n", kernel_names[k],
+               k == UNSYNC ? "find_gate_unsafe/release_gate_unsafe"
+               : k == SYNC ? "operate_flight/advance_clock from airport_sync.c"
+                           : "the same through assign_gate_partitioned");
+        int failed = bound >= 0 ? explore_systematic(bound, runs)
+                                : explore_random(seed, runs);
+        if (k != UNSYNC) sync_failed |= failed;
+        else if (explore_all && !failed) printf("  (race not found, try more runs or another seed)\n");
+    }
+
+    for (int t = 0; t < MAX_TASKS; t++) {
+        free(tasks[t].stack);
+    }
+    // Regressions in the synchronized version are what matter
+    return sync_failed;
+}
@@ -8,25 +8,85 @@
  * 3. Proper gate type matching
  * 4. Cleaning time enforcement
  * 5. Statistics protected from race conditions
+ * 6. Timing wheel for gate auto-release and cleaning completion
+ * 7. Lock-free status snapshots (per-gate seqlocks), printed outside any lock
+ * 8. Replay of large flight traces streamed from a columnar schedule
+ * 9. Terminal-partitioned gate pools with work stealing (-t)
+ * 10. Sharded airport network: diversions handed to the next airport (-n)
+ * 11. Flights as stackless coroutines on an M:N scheduler (-k)
+ * 12. Flight records from a per-thread slab allocator instead of malloc
+ *
+ * Build: gcc -pthread airport_sync.c timer_wheel.c flight_schedule.c handoff.c \
+ *            slab.c ../coro/coro.c -o airport_sync
+ *        add -DLOCKPROF ../lockprof/lockprof.c for the lock contention report
+ * Usage: ./airport_sync                      synthesized flights
+ *        ./airport_sync -s trace.csv [-v]    replay a CSV or binary trace
+ *        ./airport_sync -c trace.csv out.flt convert a CSV trace to binary
+ *        add -t to either run mode for terminal-partitioned gate pools
+ *        add -k to either run mode to fly every flight as a coroutine task
+ *        add -n airports [-T queue|unix] to run a network of airports, one
+ *        process each, with flights handed off over the chosen transport
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
 #include <time.h>
+#include <errno.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "airport_sync.h"
+#include "timer_wheel.h"
+#include "seqlock.h"
+#include "flight_schedule.h"
+#include "handoff.h"
+#include "slab.h"
+#include "../coro/coro.h"
+#include "../lockprof/lockprof.h"
 
 #define NUM_GATES 5
 #define NUM_FLIGHTS 10
 #define MAX_TURNAROUND 5
+#define REPLAY_WORKERS 16     // Flights in the air at once during a replay
+#define REPLAY_HOUR_US 10000  // Real microseconds per simulated hour during a replay
+#define NUM_TERMINALS 3       // A, B, C: the letter of each gate name
+#define TERMINAL_WORKERS 6    // Replay workers per terminal in partitioned mode
+#define MAX_SHARDS 16         // Airports in a sharded network
+#define HANDOFF_WORKERS 4     // Inbox threads per airport
+#define LATENCY_BUCKETS 40    // log2(ns) handoff latency histogram
+#define TASK_WORKERS 4        // Scheduler threads when flights run as coroutines
+#define MAX_HOLD_HOURS 2      // A task flight circles this long for a gate before diverting
+
+bool verbose_log = true;
+#define LOG(...) do { if (verbose_log) printf(__VA_ARGS__); } while (0)
+
+// Scheduling point for airport_explore.c, which includes this file with its
+// own YIELD and lock wrappers; nothing in a normal build
+#ifndef YIELD
+#define YIELD(label) ((void)0)
+#endif
 
-typedef enum { DOMESTIC, INTERNATIONAL } FlightType;
 typedef enum { AVAILABLE, OCCUPIED, MAINTENANCE } GateStatus;
 
+// Copy of the mutable gate fields, republished under gate_mutex after every
+// change so status readers never take the gate lock
 typedef struct {
+    SeqCount seq;
+    atomic_int status;
+    atomic_int current_flight;
+    atomic_int occupied_until;
+    atomic_bool is_emergency;
+} GateView;
+
+// Cache-line aligned so gates of different terminals never share a line
+typedef struct __attribute__((aligned(64))) {
     int gate_id;
     char gate_name[10];
     GateStatus status;
@@ -37,28 +97,132 @@ typedef struct {
     int cleaning_time;
     pthread_mutex_t gate_mutex;  // Individual gate lock
     sem_t gate_sem;              // Gate availability semaphore
+    TimerNode timer;             // Auto-release or cleaning-done timer (wheel_mutex)
+    unsigned timer_epoch;        // Bumped on every re-arm (gate_mutex)
+    GateView view;               // Published copy for snapshots
+    int terminal;                // Index of the terminal letter
+    sem_t* pool_sem;             // available_gates, or the terminal's pool when partitioned
 } Gate;
 
 Gate airport[NUM_GATES];
 
+// Partitioned mode: each terminal owns a contiguous run of gates, its own
+// pool semaphore and its own workers. A flight tries its home terminal
+// first and only steals from a neighbour when that is exhausted.
+typedef struct __attribute__((aligned(64))) {
+    char name;
+    int first_gate;
+    int num_gates;
+    sem_t available;             // Free gates in this terminal
+    atomic_int served_local;     // Flights placed in their home terminal
+    atomic_int stolen;           // Flights this terminal took in from other terminals
+} Terminal;
+
+Terminal terminals[NUM_TERMINALS];
+bool partitioned = false;
+int home_terminals[2][NUM_TERMINALS];  // Per flight type: terminals with a matching gate
+int num_home_terminals[2];
+
 // Global statistics with protection
 int total_flights_served = 0;
 int flights_diverted = 0;
 int emergency_flights_handled = 0;
-int simulation_time = 0;
+int simulation_time = 0;         // Hours since the clock started; traces span days
+
+// The simulated clock: hour h starts h * hour_us after clock_start
+int hour_us = 1000000;
+struct timespec clock_start;     // CLOCK_MONOTONIC
+
+// Published copy of the statistics, republished under stats_mutex
+typedef struct {
+    SeqCount seq;
+    atomic_int served;
+    atomic_int diverted;
+    atomic_int emergencies;
+} StatsView;
+
+StatsView stats_view;
+atomic_ulong airport_version;    // Bumped on every publish, lets pollers skip unchanged state
+atomic_int published_time;       // simulation_time for lock-free readers, stored under time_mutex
+
+// Sharded network: every airport is a forked process with its own gates and
+// statistics; only this report block and the transport are shared
+typedef struct {
+    atomic_long handed_out;      // Flights passed to the next airport
+    atomic_long received;        // Flights taken in from the previous airport
+    atomic_ulong latency_sum_ns;
+    atomic_ulong latency_max_ns;
+    atomic_ulong latency_hist[LATENCY_BUCKETS];
+    long served;                 // Filled in by the airport when it finishes
+    long diverted;
+    long own_flights;
+    double elapsed_ms;
+    bool consistent;
+} ShardReport;
+
+typedef struct {
+    atomic_long pending;         // Flights network-wide not yet served or finally diverted
+    ShardReport shards[MAX_SHARDS];
+} ShardNetwork;
+
+int num_shards = 1;
+int shard_id = 0;
+HandoffTransport* handoff;
+ShardNetwork* network;           // MAP_SHARED, created before the fork
+
+// Fixed-size records: flight parameters, allocated by main, freed by the flight thread
+SlabCache flight_records;
 
 // Global synchronization
 pthread_mutex_t airport_mutex;
 pthread_mutex_t stats_mutex;
 pthread_mutex_t time_mutex;
+pthread_cond_t time_cond;        // Wakes the time thread early to stop it
+bool time_stopping = false;      // Guarded by time_mutex
 sem_t available_gates;           // Counting semaphore for total available gates
 pthread_cond_t emergency_cond;   // Condition variable for emergency priority
+CoWaitQueue gate_waiters;        // Task flights holding for a gate; woken on release and every tick
+
+// Gate timers, one hour per tick; lock order is gate_mutex -> wheel_mutex
+TimerWheel gate_timers;
+pthread_mutex_t wheel_mutex;
+
+#define GATE_OF(node) ((Gate*)((char*)(node) - offsetof(Gate, timer)))
+
+// Publish gate i's current state (caller holds its gate_mutex)
+void publish_gate(int i) {
+    GateView* v = &airport[i].view;
+    seq_write_begin(&v->seq);
+    atomic_store_explicit(&v->status, airport[i].status, memory_order_relaxed);
+    atomic_store_explicit(&v->current_flight, airport[i].current_flight, memory_order_relaxed);
+    atomic_store_explicit(&v->occupied_until, airport[i].occupied_until, memory_order_relaxed);
+    atomic_store_explicit(&v->is_emergency, airport[i].is_emergency, memory_order_relaxed);
+    seq_write_end(&v->seq);
+    atomic_fetch_add_explicit(&airport_version, 1, memory_order_release);
+}
+
+// Publish the statistics (caller holds stats_mutex)
+void publish_stats() {
+    seq_write_begin(&stats_view.seq);
+    atomic_store_explicit(&stats_view.served, total_flights_served, memory_order_relaxed);
+    atomic_store_explicit(&stats_view.diverted, flights_diverted, memory_order_relaxed);
+    atomic_store_explicit(&stats_view.emergencies, emergency_flights_handled, memory_order_relaxed);
+    seq_write_end(&stats_view.seq);
+    atomic_fetch_add_explicit(&airport_version, 1, memory_order_release);
+}
 
 // Initialize airport with synchronization
-void init_airport_sync() {
+void init_airport_sync(void) {
     char* gate_names[] = {"A1", "A2", "B1", "B2", "C1"};
     FlightType types[] = {DOMESTIC, DOMESTIC, INTERNATIONAL, INTERNATIONAL, DOMESTIC};
     
+    total_flights_served = 0;
+    flights_diverted = 0;
+    emergency_flights_handled = 0;
+    simulation_time = 0;
+    atomic_store(&published_time, 0);
+    partitioned = false;
+    
     for (int i = 0; i < NUM_GATES; i++) {
         airport[i].gate_id = i;
         strcpy(airport[i].gate_name, gate_names[i]);
@@ -68,69 +232,305 @@ void init_airport_sync() {
         airport[i].occupied_until = 0;
         airport[i].is_emergency = false;
         airport[i].cleaning_time = 1;
+        airport[i].terminal = gate_names[i][0] - 'A';
+        airport[i].pool_sem = &available_gates;
         
         // Initialize gate-specific synchronization
         pthread_mutex_init(&airport[i].gate_mutex, NULL);
         sem_init(&airport[i].gate_sem, 0, 1); // Binary semaphore per gate
+        LOCKPROF_NAME(&airport[i].gate_mutex, "gate_mutex %s", gate_names[i]);
+        LOCKPROF_NAME(&airport[i].gate_sem, "gate_sem %s", gate_names[i]);
+        timer_node_init(&airport[i].timer);
+        airport[i].timer_epoch = 0;
+        seq_init(&airport[i].view.seq);
+        publish_gate(i);
     }
+    seq_init(&stats_view.seq);
+    publish_stats();
+    timer_wheel_init(&gate_timers);
+    pthread_mutex_init(&wheel_mutex, NULL);
     
     // Initialize global synchronization
     pthread_mutex_init(&airport_mutex, NULL);
     pthread_mutex_init(&stats_mutex, NULL);
     pthread_mutex_init(&time_mutex, NULL);
+    pthread_condattr_t time_attr;
+    pthread_condattr_init(&time_attr);
+    pthread_condattr_setclock(&time_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&time_cond, &time_attr);
+    pthread_condattr_destroy(&time_attr);
     sem_init(&available_gates, 0, NUM_GATES); // All gates initially available
     pthread_cond_init(&emergency_cond, NULL);
+    co_wait_init(&gate_waiters);
+    
+    if (slab_cache_init(&flight_records, "flight", sizeof(int)) != 0) {
+        printf("Cannot set up the flight record cache\n");
+        exit(1);
+    }
 }
 
-// Thread-safe display
-void display_airport_status_safe() {
-    pthread_mutex_lock(&airport_mutex);
+// Destroy what init_airport_sync and init_terminals created
+void cleanup_airport_sync(void) {
+    for (int i = 0; i < NUM_GATES; i++) {
+        pthread_mutex_destroy(&airport[i].gate_mutex);
+        sem_destroy(&airport[i].gate_sem);
+    }
+    for (int t = 0; partitioned && t < NUM_TERMINALS; t++) {
+        sem_destroy(&terminals[t].available);
+    }
+    
+    pthread_mutex_destroy(&airport_mutex);
+    pthread_mutex_destroy(&stats_mutex);
+    pthread_mutex_destroy(&time_mutex);
+    pthread_cond_destroy(&time_cond);
+    pthread_mutex_destroy(&wheel_mutex);
+    sem_destroy(&available_gates);
+    pthread_cond_destroy(&emergency_cond);
+    co_wait_destroy(&gate_waiters);
+    slab_cache_destroy(&flight_records);
+}
+
+// Group gates into terminals and give each terminal its own gate pool
+void init_terminals() {
+    for (int t = 0; t < NUM_TERMINALS; t++) {
+        terminals[t].name = 'A' + t;
+        terminals[t].first_gate = -1;
+        terminals[t].num_gates = 0;
+        atomic_init(&terminals[t].served_local, 0);
+        atomic_init(&terminals[t].stolen, 0);
+    }
+    // Gates of one terminal must be contiguous in airport[]
+    for (int i = 0; i < NUM_GATES; i++) {
+        Terminal* term = &terminals[airport[i].terminal];
+        if (term->first_gate < 0) term->first_gate = i;
+        if (term->first_gate + term->num_gates != i) {
+            printf("Gate %s is apart from the other gates of terminal %c\n",
+                   airport[i].gate_name, term->name);
+            exit(1);
+        }
+        term->num_gates++;
+        airport[i].pool_sem = &term->available;
+    }
+    for (int t = 0; t < NUM_TERMINALS; t++) {
+        sem_init(&terminals[t].available, 0, terminals[t].num_gates);
+    }
+    
+    // Home terminals per flight type: those with a gate of that type
+    for (int type = DOMESTIC; type <= INTERNATIONAL; type++) {
+        num_home_terminals[type] = 0;
+        for (int t = 0; t < NUM_TERMINALS; t++) {
+            bool match = false;
+            for (int i = terminals[t].first_gate; i < terminals[t].first_gate + terminals[t].num_gates; i++) {
+                if (airport[i].type == (FlightType)type) match = true;
+            }
+            if (match) home_terminals[type][num_home_terminals[type]++] = t;
+        }
+    }
+    partitioned = true;
+}
+
+int home_terminal(FlightType flight_type, int flight_id) {
+    if (num_home_terminals[flight_type] == 0) return 0;
+    return home_terminals[flight_type][flight_id % num_home_terminals[flight_type]];
+}
+
+// d-th terminal to visit from home: home, then neighbours outward (+1, -1, +2, ...)
+int terminal_at(int home, int d) {
+    int step = (d + 1) / 2;
+    int t = (d % 2) ? home + step : home - step;
+    return ((t % NUM_TERMINALS) + NUM_TERMINALS) % NUM_TERMINALS;
+}
+
+typedef struct {
+    GateStatus status;
+    int current_flight;
+    int occupied_until;
+    bool is_emergency;
+} GateSnapshot;
+
+typedef struct {
+    unsigned long version;       // airport_version the snapshot was taken at
+    bool consistent;             // no publish happened anywhere while copying
+    int time;
+    GateSnapshot gates[NUM_GATES];
+    int served;
+    int diverted;
+    int emergencies;
+} AirportSnapshot;
+
+#define SNAPSHOT_RETRIES 4
+
+// Copy the whole airport without taking any gate, stats or time lock. Every gate
+// and the statistics are each internally consistent; across gates the copy
+// is a single point in time when `consistent` is set, which only fails if
+// writers kept publishing through every retry.
+void take_airport_snapshot(AirportSnapshot* snap) {
+    for (int attempt = 0; attempt < SNAPSHOT_RETRIES; attempt++) {
+        unsigned long version = atomic_load_explicit(&airport_version, memory_order_acquire);
+        
+        for (int i = 0; i < NUM_GATES; i++) {
+            GateView* v = &airport[i].view;
+            GateSnapshot* g = &snap->gates[i];
+            unsigned start;
+            do {
+                start = seq_read_begin(&v->seq);
+                g->status = atomic_load_explicit(&v->status, memory_order_relaxed);
+                g->current_flight = atomic_load_explicit(&v->current_flight, memory_order_relaxed);
+                g->occupied_until = atomic_load_explicit(&v->occupied_until, memory_order_relaxed);
+                g->is_emergency = atomic_load_explicit(&v->is_emergency, memory_order_relaxed);
+            } while (seq_read_retry(&v->seq, start));
+        }
+        
+        unsigned start;
+        do {
+            start = seq_read_begin(&stats_view.seq);
+            snap->served = atomic_load_explicit(&stats_view.served, memory_order_relaxed);
+            snap->diverted = atomic_load_explicit(&stats_view.diverted, memory_order_relaxed);
+            snap->emergencies = atomic_load_explicit(&stats_view.emergencies, memory_order_relaxed);
+        } while (seq_read_retry(&stats_view.seq, start));
+        
+        atomic_thread_fence(memory_order_acquire);
+        snap->version = version;
+        snap->consistent = atomic_load_explicit(&airport_version, memory_order_relaxed) == version;
+        if (snap->consistent) break;
+    }
     
-    printf("\n=== AIRPORT STATUS [SYNC] (Time: %02d:00) ===\n", simulation_time);
+    snap->time = atomic_load_explicit(&published_time, memory_order_relaxed);
+}
+
+// Format a snapshot; no locks held
+void print_airport_snapshot(const AirportSnapshot* snap) {
+    printf("\n=== AIRPORT STATUS [SYNC] (Time: %02d:00) ===\n", snap->time);
     printf("Gate\tType\t\tStatus\t\tFlight\tUntil\tEmergency\n");
     printf("----\t----\t\t------\t\t------\t-----\t---------\n");
     
     for (int i = 0; i < NUM_GATES; i++) {
-        pthread_mutex_lock(&airport[i].gate_mutex);
-        
-        char type_str[20];
-        char status_str[20];
+        const GateSnapshot* g = &snap->gates[i];
         
-        strcpy(type_str, airport[i].type == DOMESTIC ? "Domestic" : "International");
-        strcpy(status_str, airport[i].status == AVAILABLE ? "Available" : 
-                         (airport[i].status == OCCUPIED ? "Occupied" : "Maintenance"));
+        printf("%s\t%-12s\t%-12s\t",
+               airport[i].gate_name,
+               airport[i].type == DOMESTIC ? "Domestic" : "International",
+               g->status == AVAILABLE ? "Available" :
+               (g->status == OCCUPIED ? "Occupied" : "Maintenance"));
         
-        printf("%s\t%-12s\t%-12s\t", 
-               airport[i].gate_name, type_str, status_str);
-        
-        if (airport[i].status == OCCUPIED) {
-            printf("FL%d\t%02d:00\t", 
-                   airport[i].current_flight, 
-                   airport[i].occupied_until);
+        if (g->status == OCCUPIED) {
+            printf("FL%d\t%02d:00\t", g->current_flight, g->occupied_until);
         } else {
             printf("--\t--\t");
         }
         
-        printf("%s\n", airport[i].is_emergency ? "EMERGENCY" : "");
+        printf("%s\n", g->is_emergency ? "EMERGENCY" : "");
+    }
+    
+    printf("\nStatistics [THREAD-SAFE]:\n");
+    printf("- Flights served: %d\n", snap->served);
+    printf("- Flights diverted: %d\n", snap->diverted);
+    printf("- Emergency flights handled: %d\n", snap->emergencies);
+}
+
+// Thread-safe display: snapshot first, print with no lock held
+void display_airport_status_safe() {
+    AirportSnapshot snap;
+    take_airport_snapshot(&snap);
+    print_airport_snapshot(&snap);
+}
+
+// Re-arm the gate's timer to fire at hour `until` (caller holds gate_mutex).
+// The epoch lets the time thread ignore a firing that raced with a re-arm.
+// The delay counts from the wheel's own hour: advance_clock bumps
+// simulation_time before it ticks the wheel, so the two differ in between.
+void arm_gate_timer(int i, int until) {
+    pthread_mutex_lock(&wheel_mutex);
+    long long delay = until - (long long)gate_timers.now;
+    airport[i].timer.cookie = ++airport[i].timer_epoch;
+    timer_schedule(&gate_timers, &airport[i].timer, delay > 0 ? (uint64_t)delay : 0);
+    pthread_mutex_unlock(&wheel_mutex);
+}
+
+// Try to take gate i for a flight; attempt 1 lets emergencies use any gate type
+bool try_assign_gate(int i, FlightType flight_type, int flight_id, bool is_emergency,
+                     int arrival_time, int turnaround_hours, int attempt) {
+    // Try to get exclusive access to this gate
+    if (sem_trywait(&airport[i].gate_sem) != 0) return false;
+    pthread_mutex_lock(&airport[i].gate_mutex);
+    
+    // Check if gate is suitable
+    bool gate_suitable = false;
+    
+    if (airport[i].status == AVAILABLE) {
+        // Check type compatibility
+        if (flight_type == DOMESTIC) {
+            gate_suitable = true;
+        } else {
+            gate_suitable = (airport[i].type == INTERNATIONAL);
+        }
+        YIELD("gate checked");
+        
+        // Emergency flights can use any gate
+        if (is_emergency && !gate_suitable && attempt == 1) {
+            gate_suitable = true;
+        }
+        
+        // Check cleaning time
+        if (gate_suitable && airport[i].occupied_until > arrival_time) {
+            LOG("  Gate %s needs cleaning until %02d:00\n",
+                   airport[i].gate_name, airport[i].occupied_until);
+            gate_suitable = false;
+        }
+    }
+    
+    // Never blocks: this gate's unit went back to the pool when it was freed
+    if (gate_suitable && sem_trywait(airport[i].pool_sem) != 0) {
+        gate_suitable = false;
+    }
+    
+    if (gate_suitable) {
+        
+        // Assign gate
+        airport[i].status = OCCUPIED;
+        YIELD("gate marked occupied");
+        airport[i].current_flight = flight_id;
+        airport[i].occupied_until = arrival_time + turnaround_hours + airport[i].cleaning_time;
+        airport[i].is_emergency = is_emergency;
+        
+        LOG("  ✓ Assigned Gate %s [SYNC SAFE] (Available until %02d:00)\n",
+               airport[i].gate_name, airport[i].occupied_until);
+        arm_gate_timer(i, airport[i].occupied_until);
+        publish_gate(i);
+        
+        // Update statistics safely
+        pthread_mutex_lock(&stats_mutex);
+        total_flights_served++;
+        if (is_emergency) {
+            emergency_flights_handled++;
+        }
+        publish_stats();
+        pthread_mutex_unlock(&stats_mutex);
         
         pthread_mutex_unlock(&airport[i].gate_mutex);
+        return true;
     }
     
+    // Release gate if not suitable
+    sem_post(&airport[i].gate_sem);
+    pthread_mutex_unlock(&airport[i].gate_mutex);
+    return false;
+}
+
+void divert_flight(int flight_id) {
+    LOG("  ✗ Flight FL%d diverted [SAFE DECISION]\n", flight_id);
+    
     pthread_mutex_lock(&stats_mutex);
-    printf("\nStatistics [THREAD-SAFE]:\n");
-    printf("- Flights served: %d\n", total_flights_served);
-    printf("- Flights diverted: %d\n", flights_diverted);
-    printf("- Emergency flights handled: %d\n", emergency_flights_handled);
+    flights_diverted++;
+    publish_stats();
     pthread_mutex_unlock(&stats_mutex);
-    
-    pthread_mutex_unlock(&airport_mutex);
 }
 
 // SAFE: Find and assign gate with full synchronization
 int assign_gate_safe(FlightType flight_type, int flight_id, bool is_emergency,
                     int arrival_time, int turnaround_hours) {
     
-    printf("\nFlight FL%d %sarriving at %02d:00 (Type: %s, Turnaround: %d hours)\n",
+    LOG("\nFlight FL%d %sarriving at %02d:00 (Type: %s, Turnaround: %d hours)\n",
            flight_id, is_emergency ? "[EMERGENCY] " : "", 
            arrival_time, flight_type == DOMESTIC ? "Domestic" : "International",
            turnaround_hours);
@@ -145,62 +545,9 @@ int assign_gate_safe(FlightType flight_type, int flight_id, bool is_emergency,
     // Try each gate with proper locking
     for (int attempt = 0; attempt < 2; attempt++) { // Try twice for emergencies
         for (int i = 0; i < NUM_GATES; i++) {
-            // Try to get exclusive access to this gate
-            if (sem_trywait(&airport[i].gate_sem) == 0) {
-                pthread_mutex_lock(&airport[i].gate_mutex);
-                
-                // Check if gate is suitable
-                bool gate_suitable = false;
-                
-                if (airport[i].status == AVAILABLE) {
-                    // Check type compatibility
-                    if (flight_type == DOMESTIC) {
-                        gate_suitable = true;
-                    } else {
-                        gate_suitable = (airport[i].type == INTERNATIONAL);
-                    }
-                    
-                    // Emergency flights can use any gate
-                    if (is_emergency && !gate_suitable && attempt == 1) {
-                        gate_suitable = true;
-                    }
-                    
-                    // Check cleaning time
-                    if (gate_suitable && airport[i].occupied_until > arrival_time) {
-                        printf("  Gate %s needs cleaning until %02d:00\n",
-                               airport[i].gate_name, airport[i].occupied_until);
-                        gate_suitable = false;
-                    }
-                }
-                
-                if (gate_suitable) {
-                    // Wait for global gate semaphore
-                    sem_wait(&available_gates);
-                    
-                    // Assign gate
-                    airport[i].status = OCCUPIED;
-                    airport[i].current_flight = flight_id;
-                    airport[i].occupied_until = arrival_time + turnaround_hours + airport[i].cleaning_time;
-                    airport[i].is_emergency = is_emergency;
-                    
-                    printf("  ✓ Assigned Gate %s [SYNC SAFE] (Available until %02d:00)\n",
-                           airport[i].gate_name, airport[i].occupied_until);
-                    
-                    // Update statistics safely
-                    pthread_mutex_lock(&stats_mutex);
-                    total_flights_served++;
-                    if (is_emergency) {
-                        emergency_flights_handled++;
-                    }
-                    pthread_mutex_unlock(&stats_mutex);
-                    
-                    pthread_mutex_unlock(&airport[i].gate_mutex);
-                    return i; // Success
-                }
-                
-                // Release gate if not suitable
-                sem_post(&airport[i].gate_sem);
-                pthread_mutex_unlock(&airport[i].gate_mutex);
+            if (try_assign_gate(i, flight_type, flight_id, is_emergency,
+                                arrival_time, turnaround_hours, attempt)) {
+                return i; // Success
             }
         }
         
@@ -208,12 +555,42 @@ int assign_gate_safe(FlightType flight_type, int flight_id, bool is_emergency,
     }
     
     // No gate available
-    printf("  ✗ No suitable gate available! Flight FL%d diverted [SAFE DECISION]\n", flight_id);
+    LOG("  ✗ No suitable gate available for Flight FL%d\n", flight_id);
+    return -1;
+}
+
+// SAFE: Partitioned assignment - home terminal first, then steal from neighbours.
+// Never touches airport_mutex or gates of other terminals unless stealing.
+int assign_gate_partitioned(FlightType flight_type, int flight_id, bool is_emergency,
+                            int arrival_time, int turnaround_hours, int home) {
     
-    pthread_mutex_lock(&stats_mutex);
-    flights_diverted++;
-    pthread_mutex_unlock(&stats_mutex);
+    LOG("\nFlight FL%d %sarriving at %02d:00 (Type: %s, Turnaround: %d hours, Terminal %c)\n",
+           flight_id, is_emergency ? "[EMERGENCY] " : "", 
+           arrival_time, flight_type == DOMESTIC ? "Domestic" : "International",
+           turnaround_hours, terminals[home].name);
+    
+    for (int attempt = 0; attempt < 2; attempt++) { // Try twice for emergencies
+        for (int d = 0; d < NUM_TERMINALS; d++) {
+            Terminal* term = &terminals[terminal_at(home, d)];
+            
+            for (int i = term->first_gate; i < term->first_gate + term->num_gates; i++) {
+                if (try_assign_gate(i, flight_type, flight_id, is_emergency,
+                                    arrival_time, turnaround_hours, attempt)) {
+                    if (d == 0) {
+                        atomic_fetch_add_explicit(&term->served_local, 1, memory_order_relaxed);
+                    } else {
+                        atomic_fetch_add_explicit(&term->stolen, 1, memory_order_relaxed);
+                        LOG("  (stolen from Terminal %c)\n", term->name);
+                    }
+                    return i;
+                }
+            }
+        }
+        
+        if (!is_emergency) break; // Non-emergency flights only try once
+    }
     
+    LOG("  ✗ No suitable gate available for Flight FL%d\n", flight_id);
     return -1;
 }
 
@@ -223,26 +600,200 @@ void release_gate_safe(int gate_index, int flight_id) {
     
     pthread_mutex_lock(&airport[gate_index].gate_mutex);
     
-    printf("\nFlight FL%d leaving Gate %s at %02d:00 [SYNC RELEASE]\n",
-           flight_id, airport[gate_index].gate_name, simulation_time);
+    // The time thread may already have auto-released this gate
+    if (airport[gate_index].current_flight != flight_id) {
+        LOG("\nFlight FL%d already auto-released from Gate %s\n",
+               flight_id, airport[gate_index].gate_name);
+        pthread_mutex_unlock(&airport[gate_index].gate_mutex);
+        return;
+    }
+    
+    pthread_mutex_lock(&time_mutex);
+    int now = simulation_time;
+    pthread_mutex_unlock(&time_mutex);
+    
+    LOG("\nFlight FL%d leaving Gate %s at %02d:00 [SYNC RELEASE]\n",
+           flight_id, airport[gate_index].gate_name, now);
     
     airport[gate_index].status = AVAILABLE;
+    YIELD("gate marked available");
     airport[gate_index].current_flight = -1;
     airport[gate_index].is_emergency = false;
     
     // Set cleaning time
-    pthread_mutex_lock(&time_mutex);
-    airport[gate_index].occupied_until = simulation_time + airport[gate_index].cleaning_time;
-    pthread_mutex_unlock(&time_mutex);
+    airport[gate_index].occupied_until = now + airport[gate_index].cleaning_time;
+    
+    // Replace the auto-release timer with the cleaning-done timer
+    arm_gate_timer(gate_index, airport[gate_index].occupied_until);
+    publish_gate(gate_index);
     
     // Signal gate availability
-    sem_post(&available_gates);
+    sem_post(airport[gate_index].pool_sem);
     sem_post(&airport[gate_index].gate_sem);
     
     pthread_mutex_unlock(&airport[gate_index].gate_mutex);
     
-    // Wake up any waiting emergency flights
+    // Wake up any waiting emergency flights, and task flights holding for a gate
     pthread_cond_signal(&emergency_cond);
+    co_wake_all(&gate_waiters);
+}
+
+// Pass a flight this airport cannot place to the next airport in the ring.
+// False when every airport has turned it away or the neighbour's inbox is full.
+bool handoff_flight(int flight_id, FlightType flight_type, bool is_emergency,
+                    int arrival_time, int turnaround_hours, int turnaround_us, int hops) {
+    if (num_shards < 2 || hops + 1 >= num_shards) return false;
+    
+    HandoffMsg msg = {
+        .kind = HANDOFF_FLIGHT,
+        .flight_id = flight_id,
+        .type = flight_type,
+        .emergency = is_emergency,
+        .hops = hops + 1,
+        .from = shard_id,
+        .arrival = arrival_time,
+        .turnaround = turnaround_hours,
+        .turnaround_us = turnaround_us,
+    };
+    int next = (shard_id + 1) % num_shards;
+    
+    msg.sent_ns = handoff_now_ns();
+    if (handoff->send(handoff, next, &msg, false) != 0) return false;
+    
+    atomic_fetch_add(&network->shards[shard_id].handed_out, 1);
+    LOG("  → Flight FL%d handed off to airport %d\n", flight_id, next);
+    return true;
+}
+
+// A flight is done for good; the last one network-wide stops every inbox
+void settle_flight() {
+    if (num_shards < 2) return;
+    if (atomic_fetch_sub(&network->pending, 1) != 1) return;
+    
+    HandoffMsg stop = { .kind = HANDOFF_STOP };
+    for (int s = 0; s < num_shards; s++) {
+        for (int w = 0; w < HANDOFF_WORKERS; w++) {
+            handoff->send(handoff, s, &stop, true);
+        }
+    }
+}
+
+// Get gate assignment safely, through the terminal pools when partitioned
+int take_gate(FlightType flight_type, int flight_id, bool is_emergency,
+              int arrival_time, int turnaround_hours) {
+    return partitioned
+        ? assign_gate_partitioned(flight_type, flight_id, is_emergency, arrival_time,
+                                  turnaround_hours, home_terminal(flight_type, flight_id))
+        : assign_gate_safe(flight_type, flight_id, is_emergency,
+                           arrival_time, turnaround_hours);
+}
+
+// After the turnaround: release the gate, or hand off / divert a flight that got none
+void complete_flight(int gate_assigned, int flight_id, FlightType flight_type, bool is_emergency,
+                     int arrival_time, int turnaround_hours, int turnaround_us, int hops) {
+    if (gate_assigned != -1) {
+        // Release gate safely
+        release_gate_safe(gate_assigned, flight_id);
+    } else if (handoff_flight(flight_id, flight_type, is_emergency, arrival_time,
+                              turnaround_hours, turnaround_us, hops)) {
+        return; // The next airport owns it now
+    } else {
+        divert_flight(flight_id);
+    }
+    settle_flight();
+    
+    LOG("Flight FL%d completed operations [THREAD-SAFE]\n", flight_id);
+}
+
+// Real time at which the simulated clock is `us` microseconds past hour 0
+struct timespec clock_at_us(long long us) {
+    long long ns = clock_start.tv_nsec + (us % 1000000) * 1000;
+    struct timespec at = { clock_start.tv_sec + (time_t)(us / 1000000) + (time_t)(ns / 1000000000), ns % 1000000000 };
+    return at;
+}
+
+// Current simulated hour
+int clock_hour() {
+    pthread_mutex_lock(&time_mutex);
+    int now = simulation_time;
+    pthread_mutex_unlock(&time_mutex);
+    return now;
+}
+
+// Microseconds from now until the clock is `us` past hour 0 (<= 0 if it is past)
+long long us_until(long long us) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return us - ((now.tv_sec - clock_start.tv_sec) * 1000000ll + (now.tv_nsec - clock_start.tv_nsec) / 1000);
+}
+
+// Sleep until the clock is `us` past hour 0
+void wait_until_us(long long us) {
+    struct timespec at = clock_at_us(us);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, NULL) == EINTR) {
+    }
+}
+
+// Fly one flight: wait for arrival, take a gate, turn around, release.
+// hops counts the airports that already turned it away.
+void operate_flight(int flight_id, FlightType flight_type, bool is_emergency,
+                    int arrival_time, int turnaround_hours,
+                    int arrival_delay_us, int turnaround_us, int hops) {
+    // Wait until arrival
+    if (arrival_delay_us > 0) usleep(arrival_delay_us);
+    
+    int gate_assigned = take_gate(flight_type, flight_id, is_emergency,
+                                  arrival_time, turnaround_hours);
+    
+    // Simulate turnaround
+    YIELD("turnaround");
+    if (gate_assigned != -1 && turnaround_us > 0) usleep(turnaround_us);
+    
+    complete_flight(gate_assigned, flight_id, flight_type, is_emergency,
+                    arrival_time, turnaround_hours, turnaround_us, hops);
+}
+
+// Coroutine flight (-k): the same steps as operate_flight, but waiting for
+// arrival and turnaround suspends the task instead of its thread. A flight
+// that finds no gate holds on gate_waiters for up to MAX_HOLD_HOURS and
+// retries as gates free up, landing at the hour it gets one.
+typedef struct {
+    CoTask task;                 // must come first
+    int flight_id;
+    int gate;
+    int arrival_time;
+    int turnaround_hours;
+    long long arrive_at_us;      // Microseconds past hour 0
+    int turnaround_us;
+    int hold_until;              // Hour the flight gives up holding
+    unsigned long ticket;        // gate_waiters ticket for the current attempt
+    bool international;
+    bool is_emergency;
+} FlightTask;
+
+int flight_step(CoTask* t) {
+    FlightTask* f = (FlightTask*)t;
+    FlightType flight_type = f->international ? INTERNATIONAL : DOMESTIC;
+    
+    CO_BEGIN(t);
+    CO_SLEEP(t, us_until(f->arrive_at_us) > 0 ? us_until(f->arrive_at_us) * 1000ull : 0);
+    
+    f->hold_until = f->arrival_time + MAX_HOLD_HOURS;
+    for (;;) {
+        f->ticket = co_wait_ticket(&gate_waiters);
+        int now = clock_hour();
+        f->gate = take_gate(flight_type, f->flight_id, f->is_emergency,
+                            now > f->arrival_time ? now : f->arrival_time, f->turnaround_hours);
+        if (f->gate != -1 || now >= f->hold_until) break;
+        CO_WAIT(t, &gate_waiters, f->ticket);
+    }
+    if (f->gate != -1) {
+        CO_SLEEP(t, f->turnaround_us * 1000ull);
+    }
+    
+    complete_flight(f->gate, f->flight_id, flight_type, f->is_emergency,
+                    f->arrival_time, f->turnaround_hours, f->turnaround_us, 0);
+    CO_END(t);
 }
 
 // Flight thread with synchronization
@@ -259,73 +810,465 @@ void* flight_thread_safe(void* arg) {
     
     int turnaround_hours = 1 + (rand() % MAX_TURNAROUND);
     
-    // Wait until arrival
-    usleep(arrival_time * 50000);
+    operate_flight(flight_id, flight_type, is_emergency, arrival_time, turnaround_hours,
+                   arrival_time * 50000, turnaround_hours * 100000, 0);
     
-    // Get gate assignment safely
-    int gate_assigned = assign_gate_safe(flight_type, flight_id, is_emergency,
-                                        arrival_time, turnaround_hours);
+    slab_free(arg); // Back to main's heap, lock-free
+    return NULL;
+}
+
+// This airport's trace rows in arrival order, claimed one at a time
+typedef struct {
+    const FlightSchedule* sched;
+    size_t* rows;
+    size_t count;
+    atomic_size_t next;
+} FlightQueue;
+
+typedef struct {
+    FlightQueue* queue;
+    int terminal;                // -1: any flight; else this terminal's queue
+} ReplayWorker;
+
+static int by_arrival(const void* a, const void* b, void* ctx) {
+    const FlightSchedule* sched = ctx;
+    size_t x = *(const size_t*)a, y = *(const size_t*)b;
+    if (sched->arrival[x] != sched->arrival[y]) return sched->arrival[x] < sched->arrival[y] ? -1 : 1;
+    return x < y ? -1 : x > y;
+}
+
+// Queue this airport's rows; a trace need not be sorted by arrival, but
+// the workers fly flights as the clock reaches them (binary traces are
+// written sorted, so only an unsorted CSV pays for the sort here)
+int flight_queue_init(FlightQueue* q, const FlightSchedule* sched) {
+    q->sched = sched;
+    q->count = 0;
+    q->rows = malloc((sched->count / num_shards + 1) * sizeof(size_t));
+    if (!q->rows) return -1;
+    for (size_t k = shard_id; k < sched->count; k += num_shards) {
+        q->rows[q->count++] = k;
+    }
+    if (!sched->sorted) {
+        qsort_r(q->rows, q->count, sizeof(size_t), by_arrival, (void*)sched);
+    }
+    atomic_init(&q->next, 0);
+    return 0;
+}
+
+// Split an airport's queue into one per home terminal, keeping arrival order
+int flight_queue_split(const FlightQueue* all, FlightQueue per[NUM_TERMINALS]) {
+    const FlightSchedule* sched = all->sched;
+    size_t counts[NUM_TERMINALS] = {0};
+    int* home = malloc((all->count + 1) * sizeof(int));
     
-    if (gate_assigned != -1) {
-        // Simulate turnaround
-        usleep(turnaround_hours * 100000);
-        
-        // Release gate safely
-        release_gate_safe(gate_assigned, flight_id);
+    if (!home) return -1;
+    for (size_t n = 0; n < all->count; n++) {
+        size_t k = all->rows[n];
+        FlightType flight_type = (sched->flags[k] & FLIGHT_INTERNATIONAL) ? INTERNATIONAL : DOMESTIC;
+        home[n] = home_terminal(flight_type, sched->flight_id[k]);
+        counts[home[n]]++;
+    }
+    for (int t = 0; t < NUM_TERMINALS; t++) {
+        per[t].sched = sched;
+        per[t].count = 0;
+        per[t].rows = malloc((counts[t] + 1) * sizeof(size_t));
+        atomic_init(&per[t].next, 0);
+        if (!per[t].rows) {
+            while (t-- > 0) free(per[t].rows);
+            free(home);
+            return -1;
+        }
+    }
+    for (size_t n = 0; n < all->count; n++) {
+        per[home[n]].rows[per[home[n]].count++] = all->rows[n];
+    }
+    free(home);
+    return 0;
+}
+
+bool flight_queue_next(FlightQueue* q, size_t* row) {
+    size_t n = atomic_fetch_add_explicit(&q->next, 1, memory_order_relaxed);
+    if (n >= q->count) return false;
+    *row = q->rows[n];
+    return true;
+}
+
+// Keep a terminal's workers on their own share of the CPUs so the gate
+// state they touch stays socket-local (contiguous CPU ids per terminal)
+void pin_to_terminal(int t) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < NUM_TERMINALS) return;
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (long c = t * ncpu / NUM_TERMINALS; c < (t + 1) * ncpu / NUM_TERMINALS; c++) {
+        CPU_SET(c, &set);
     }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// Replay worker: pulls the next flight off the shared schedule until it runs
+// dry, and flies it when the clock reaches its arrival hour
+void* schedule_worker(void* arg) {
+    ReplayWorker* w = arg;
+    const FlightSchedule* sched = w->queue->sched;
+    size_t k;
     
-    printf("Flight FL%d completed operations [THREAD-SAFE]\n", flight_id);
+    if (w->terminal >= 0) pin_to_terminal(w->terminal);
     
-    free(arg); // Free dynamically allocated parameter
+    while (flight_queue_next(w->queue, &k)) {
+        FlightType flight_type = (sched->flags[k] & FLIGHT_INTERNATIONAL) ? INTERNATIONAL : DOMESTIC;
+        bool is_emergency = (sched->flags[k] & FLIGHT_EMERGENCY) != 0;
+        
+        wait_until_us((long long)sched->arrival[k] * hour_us);
+        operate_flight(sched->flight_id[k], flight_type, is_emergency,
+                       sched->arrival[k], sched->turnaround[k],
+                       0, sched->turnaround[k] * hour_us, 0);
+    }
     return NULL;
 }
 
-// Time simulator with synchronization
+// Inbox worker: flies flights handed over by the previous airport until told to stop
+void* handoff_inbox(void* arg) {
+    ShardReport* report = &network->shards[shard_id];
+    HandoffMsg msg;
+    (void)arg;
+    
+    while (handoff->recv(handoff, shard_id, &msg) == 0 && msg.kind != HANDOFF_STOP) {
+        uint64_t latency = handoff_now_ns() - msg.sent_ns;
+        int bucket = 64 - __builtin_clzll(latency | 1);
+        if (bucket >= LATENCY_BUCKETS) bucket = LATENCY_BUCKETS - 1;
+        
+        atomic_fetch_add(&report->received, 1);
+        atomic_fetch_add(&report->latency_sum_ns, latency);
+        atomic_fetch_add(&report->latency_hist[bucket], 1);
+        uint64_t max = atomic_load(&report->latency_max_ns);
+        while (latency > max && !atomic_compare_exchange_weak(&report->latency_max_ns, &max, latency)) {
+        }
+        
+        operate_flight(msg.flight_id, msg.type, msg.emergency, msg.arrival, msg.turnaround,
+                       0, msg.turnaround_us, msg.hops);
+    }
+    return NULL;
+}
+
+// Upper bound in microseconds of the bucket holding quantile q of the handoff latencies
+static double latency_quantile_us(const unsigned long* hist, unsigned long total,
+                                  unsigned long max_ns, double q) {
+    unsigned long seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += hist[b];
+        if (total > 0 && seen >= q * total) {
+            return (double)((1ul << b) < max_ns ? (1ul << b) : max_ns) / 1e3;
+        }
+    }
+    return max_ns / 1e3;
+}
+
+// Fork one process per airport. Returns in each airport with shard_id set;
+// the parent waits for all of them, prints the network report and exits.
+void run_shard_network(const char* transport, long total_flights) {
+    network = mmap(NULL, sizeof(ShardNetwork), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    handoff = handoff_transport_create(transport, num_shards);
+    if (network == MAP_FAILED || !handoff) {
+        printf("Cannot set up %s handoff between %d airports\n", transport, num_shards);
+        exit(1);
+    }
+    atomic_init(&network->pending, total_flights);
+    
+    fflush(stdout);
+    pid_t pids[MAX_SHARDS];
+    for (int s = 0; s < num_shards; s++) {
+        pids[s] = fork();
+        if (pids[s] == 0) {
+            shard_id = s;
+            setvbuf(stdout, NULL, _IOFBF, 1 << 16); // one block of output per airport
+            return;
+        }
+    }
+    
+    bool all_ok = true;
+    for (int s = 0; s < num_shards; s++) {
+        int status;
+        waitpid(pids[s], &status, 0);
+        all_ok = all_ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    
+    printf("\n===============================================\n");
+    printf("AIRPORT NETWORK (%d airports, %s handoff)\n", num_shards, handoff->name);
+    printf("===============================================\n");
+    
+    long served = 0, diverted = 0, handoffs = 0;
+    unsigned long latency_sum = 0, latency_max = 0, hist[LATENCY_BUCKETS] = {0};
+    double elapsed = 0;
+    for (int s = 0; s < num_shards; s++) {
+        ShardReport* r = &network->shards[s];
+        long received = atomic_load(&r->received);
+        
+        printf("Airport %d: %ld own + %ld received -> %ld served, %ld diverted, %ld handed off %s\n",
+               s, r->own_flights, received, r->served, r->diverted,
+               atomic_load(&r->handed_out), r->consistent ? "✓" : "⚠️");
+        served += r->served;
+        diverted += r->diverted;
+        handoffs += received;
+        latency_sum += atomic_load(&r->latency_sum_ns);
+        if (atomic_load(&r->latency_max_ns) > latency_max) latency_max = atomic_load(&r->latency_max_ns);
+        for (int b = 0; b < LATENCY_BUCKETS; b++) hist[b] += atomic_load(&r->latency_hist[b]);
+        if (r->elapsed_ms > elapsed) elapsed = r->elapsed_ms;
+    }
+    
+    printf("\nNetwork: served + diverted = %ld + %ld = %ld (expected %ld)\n",
+           served, diverted, served + diverted, total_flights);
+    if (served + diverted == total_flights && all_ok) {
+        printf("✓ NETWORK STATISTICS CONSISTENT!\n");
+    } else {
+        all_ok = false;
+        printf("⚠️  NETWORK STATISTICS INCONSISTENT!\n");
+    }
+    printf("Handoffs: %ld in %.1f ms (%.0f/s)\n", handoffs, elapsed,
+           elapsed > 0 ? handoffs * 1e3 / elapsed : 0.0);
+    if (handoffs > 0) {
+        printf("Handoff latency: mean %.1f us, p50 <= %.1f us, p99 <= %.1f us, max %.1f us\n",
+               latency_sum / 1e3 / handoffs,
+               latency_quantile_us(hist, handoffs, latency_max, 0.50),
+               latency_quantile_us(hist, handoffs, latency_max, 0.99), latency_max / 1e3);
+    }
+    
+    handoff->destroy(handoff);
+    munmap(network, sizeof(ShardNetwork));
+    exit(all_ok ? 0 : 1);
+}
+
+static double elapsed_ms(struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Fly this airport's flights as coroutine tasks: the synthesized ones
+// (sched == NULL) or every trace row this airport owns
+void run_flight_tasks(const FlightSchedule* sched) {
+    size_t count = sched ? (sched->count + num_shards - 1 - shard_id) / num_shards : NUM_FLIGHTS;
+    FlightTask* tasks = calloc(count ? count : 1, sizeof(FlightTask));
+    CoScheduler co;
+    struct timespec start;
+    
+    if (!tasks) {
+        printf("Cannot allocate %zu flight tasks\n", count);
+        return;
+    }
+    co_sched_init(&co, TASK_WORKERS, false);
+    
+    for (size_t n = 0; n < count; n++) {
+        FlightTask* f = &tasks[n];
+        if (sched) {
+            size_t k = n * num_shards + shard_id;
+            f->flight_id = sched->flight_id[k];
+            f->international = (sched->flags[k] & FLIGHT_INTERNATIONAL) != 0;
+            f->is_emergency = (sched->flags[k] & FLIGHT_EMERGENCY) != 0;
+            f->arrival_time = sched->arrival[k];
+            f->turnaround_hours = sched->turnaround[k];
+            f->arrive_at_us = (long long)sched->arrival[k] * hour_us;
+            f->turnaround_us = sched->turnaround[k] * hour_us;
+        } else {
+            // Same flights and staggering as the thread version
+            f->flight_id = shard_id * NUM_FLIGHTS + (int)n + 1;
+            f->international = rand() % 2;
+            f->is_emergency = (n % 4) == 0;
+            pthread_mutex_lock(&time_mutex);
+            f->arrival_time = simulation_time + (rand() % 6);
+            pthread_mutex_unlock(&time_mutex);
+            f->turnaround_hours = 1 + (rand() % MAX_TURNAROUND);
+            f->arrive_at_us = (long long)n * 200000 + f->arrival_time * 50000;
+            f->turnaround_us = f->turnaround_hours * 100000;
+        }
+        co_spawn(&co, &f->task, flight_step);
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    co_sched_run(&co);
+    printf("Flew %zu flights as tasks on %d threads (%zu bytes each) in %.1f ms, %lu task steps\n",
+           count, co.workers, sizeof(FlightTask), elapsed_ms(&start), co.steps);
+    
+    co_sched_destroy(&co);
+    free(tasks);
+}
+
+// Load a trace, reporting the malformed CSV lines
+int load_schedule(const char* path, FlightSchedule* sched) {
+    struct timespec start;
+    FlightScheduleError error;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (flight_schedule_load(path, sched, 0, &error) != 0) {
+        if (error.malformed > 0) {
+            printf("%zu malformed flight line(s) in %s, the first on line %ld (byte %ld)\n",
+                   error.malformed, path, error.line, error.offset);
+        } else {
+            printf("Cannot load flight schedule %s\n", path);
+        }
+        return -1;
+    }
+    printf("Loaded %zu flights from %s in %.1f ms (%s)\n", sched->count, path,
+           elapsed_ms(&start), sched->mapped ? "mapped binary" : "parsed CSV");
+    return 0;
+}
+
+// Gate whose timer fired on this tick, with the epoch it was armed under
+typedef struct {
+    Gate* gate;
+    unsigned epoch;
+} ExpiredTimer;
+
+typedef struct {
+    ExpiredTimer items[NUM_GATES]; // at most one armed timer per gate
+    int count;
+} ExpiredBatch;
+
+static void collect_expired(TimerNode* node, void* ctx) {
+    ExpiredBatch* batch = ctx;
+    batch->items[batch->count].gate = GATE_OF(node);
+    batch->items[batch->count].epoch = node->cookie;
+    batch->count++;
+}
+
+// Handle one expiry (caller holds gate_mutex)
+static void gate_timer_expired(Gate* gate, int current_time) {
+    if (gate->status == OCCUPIED) {
+        LOG("\n[Auto-release SYNC] Gate %s now available (Flight FL%d expired)\n",
+               gate->gate_name, gate->current_flight);
+        
+        gate->status = AVAILABLE;
+        YIELD("gate auto-released");
+        gate->current_flight = -1;
+        gate->is_emergency = false;
+        gate->occupied_until = current_time + gate->cleaning_time;
+        
+        // Give back what the flight held on assignment
+        sem_post(gate->pool_sem);
+        sem_post(&gate->gate_sem);
+        
+        arm_gate_timer(gate->gate_id, gate->occupied_until);
+        publish_gate(gate->gate_id);
+    } else {
+        LOG("\n[Cleaning done SYNC] Gate %s ready at %02d:00\n",
+               gate->gate_name, current_time);
+    }
+}
+
+// One simulated hour: advance the clock and fire the gate timers now due.
+// Each tick touches only expiring gates.
+void advance_clock() {
+    ExpiredBatch batch;
+    
+    pthread_mutex_lock(&time_mutex);
+    int current_time = ++simulation_time;
+    atomic_store_explicit(&published_time, current_time, memory_order_relaxed);
+    pthread_mutex_unlock(&time_mutex);
+    
+    batch.count = 0;
+    pthread_mutex_lock(&wheel_mutex);
+    timer_wheel_tick(&gate_timers, collect_expired, &batch);
+    pthread_mutex_unlock(&wheel_mutex);
+    
+    for (int k = 0; k < batch.count; k++) {
+        Gate* gate = batch.items[k].gate;
+        pthread_mutex_lock(&gate->gate_mutex);
+        if (gate->timer_epoch == batch.items[k].epoch) {
+            gate_timer_expired(gate, current_time);
+        }
+        pthread_mutex_unlock(&gate->gate_mutex);
+    }
+    // Gates may have finished cleaning, and holding flights may have run out of time
+    co_wake_all(&gate_waiters);
+}
+
+// Time simulator with synchronization: one advance_clock per hour_us of
+// real time. Runs until stop_time_simulator.
 void* time_simulator_safe(void* arg) {
     while (1) {
-        sleep(1);
-        
         pthread_mutex_lock(&time_mutex);
-        simulation_time = (simulation_time + 1) % 24;
+        // Ticks follow the clock, so a late tick is caught up right away
+        struct timespec next_tick = clock_at_us((long long)(simulation_time + 1) * hour_us);
+        while (!time_stopping &&
+               pthread_cond_timedwait(&time_cond, &time_mutex, &next_tick) != ETIMEDOUT) {
+        }
+        bool stopping = time_stopping;
         pthread_mutex_unlock(&time_mutex);
+        if (stopping) break;
         
-        // Auto-release expired gates safely
-        for (int i = 0; i < NUM_GATES; i++) {
-            if (sem_trywait(&airport[i].gate_sem) == 0) {
-                pthread_mutex_lock(&airport[i].gate_mutex);
-                
-                pthread_mutex_lock(&time_mutex);
-                int current_time = simulation_time;
-                pthread_mutex_unlock(&time_mutex);
-                
-                if (airport[i].status == OCCUPIED && 
-                    airport[i].occupied_until <= current_time) {
-                    
-                    printf("\n[Auto-release SYNC] Gate %s now available (Flight FL%d expired)\n",
-                           airport[i].gate_name, airport[i].current_flight);
-                    
-                    airport[i].status = AVAILABLE;
-                    airport[i].current_flight = -1;
-                    airport[i].is_emergency = false;
-                    airport[i].occupied_until = current_time + airport[i].cleaning_time;
-                    
-                    sem_post(&available_gates);
-                }
-                
-                sem_post(&airport[i].gate_sem);
-                pthread_mutex_unlock(&airport[i].gate_mutex);
-            }
-        }
+        advance_clock();
     }
     return NULL;
 }
 
-int main() {
+void stop_time_simulator(pthread_t time_thread) {
+    pthread_mutex_lock(&time_mutex);
+    time_stopping = true;
+    pthread_cond_signal(&time_cond);
+    pthread_mutex_unlock(&time_mutex);
+    pthread_join(time_thread, NULL);
+}
+
+// The benchmark (bench/bench.c) links this file for the gate functions
+#ifndef AIRPORT_SYNC_NO_MAIN
+int main(int argc, char** argv) {
     pthread_t flights[NUM_FLIGHTS];
     pthread_t time_thread;
+    FlightSchedule schedule;
+    FlightQueue queue;
+    FlightQueue terminal_queues[NUM_TERMINALS];
+    bool replay = false;
+    bool verbose = false;
+    bool use_terminals = false;
+    bool use_tasks = false;
+    const char* transport = "queue";
+    int expected_flights = NUM_FLIGHTS;
     
-    srand(time(NULL));
+    if (argc == 4 && strcmp(argv[1], "-c") == 0) {
+        if (load_schedule(argv[2], &schedule) != 0) return 1;
+        int rc = flight_schedule_write(&schedule, argv[3]);
+        printf(rc == 0 ? "Wrote %s\n" : "Cannot write %s\n", argv[3]);
+        flight_schedule_free(&schedule);
+        return rc == 0 ? 0 : 1;
+    }
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-s") == 0 && a + 1 < argc) {
+            if (load_schedule(argv[++a], &schedule) != 0) return 1;
+            replay = true;
+            expected_flights = (int)schedule.count;
+        } else if (strcmp(argv[a], "-v") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[a], "-t") == 0) {
+            use_terminals = true;
+        } else if (strcmp(argv[a], "-k") == 0) {
+            use_tasks = true;
+        } else if (strcmp(argv[a], "-n") == 0 && a + 1 < argc) {
+            num_shards = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "-T") == 0 && a + 1 < argc) {
+            transport = argv[++a];
+        }
+    }
+    if (num_shards < 1 || num_shards > MAX_SHARDS) {
+        printf("Airports must be between 1 and %d\n", MAX_SHARDS);
+        return 1;
+    }
+    if (replay || num_shards > 1) verbose_log = verbose;
+    if (replay) hour_us = REPLAY_HOUR_US;
+    
+    if (num_shards > 1) {
+        run_shard_network(transport, replay ? (long)schedule.count : (long)num_shards * NUM_FLIGHTS);
+        // Only the airports get here
+        if (replay) {
+            expected_flights = (int)((schedule.count + num_shards - 1 - shard_id) / num_shards);
+        }
+        network->shards[shard_id].own_flights = expected_flights;
+    }
+    
+    srand(time(NULL) + shard_id);
     init_airport_sync();
+    if (use_terminals) init_terminals();
     
     printf("===============================================\n");
     printf("AIRPORT GATE ASSIGNMENT - SYNCHRONIZED\n");
@@ -333,30 +1276,94 @@ int main() {
     printf("Gates: %d (A1,A2: Domestic, B1,B2: International, C1: Domestic)\n", NUM_GATES);
     printf("Synchronization: Mutex + Semaphores + Condition Variables\n");
     printf("Features: Priority, Type Safety, Cleaning Time, Thread-Safe Stats\n\n");
+    if (num_shards > 1) {
+        printf("Airport %d of %d, diversions handed to airport %d over %s\n\n",
+               shard_id, num_shards, (shard_id + 1) % num_shards, handoff->name);
+    }
     
-    // Start time simulator
+    // Start time simulator; hour 0 of a trace is now
+    clock_gettime(CLOCK_MONOTONIC, &clock_start);
     pthread_create(&time_thread, NULL, time_simulator_safe, NULL);
     
+    // Inbox for flights handed over by the previous airport
+    pthread_t inbox[HANDOFF_WORKERS];
+    struct timespec run_start;
+    clock_gettime(CLOCK_MONOTONIC, &run_start);
+    if (num_shards > 1) {
+        for (int w = 0; w < HANDOFF_WORKERS; w++) {
+            pthread_create(&inbox[w], NULL, handoff_inbox, NULL);
+        }
+    }
+    
     display_airport_status_safe();
     
-    // Create flight threads with dynamically allocated parameters
-    for (int i = 0; i < NUM_FLIGHTS; i++) {
-        int* flight_params = malloc(sizeof(int));
-        *flight_params = (i + 1);
-        *flight_params |= ((rand() % 2) << 8);
-        *flight_params |= (((i % 4) == 0) << 9);
+    if (use_tasks) {
+        // One coroutine per flight instead of a thread or a worker pool
+        run_flight_tasks(replay ? &schedule : NULL);
+    } else if (replay) {
+        // Stream the schedule through a fixed set of workers; partitioned
+        // mode gives every terminal its own workers and its own queue
+        int nworkers = partitioned ? NUM_TERMINALS * TERMINAL_WORKERS : REPLAY_WORKERS;
+        pthread_t workers[nworkers];
+        ReplayWorker worker_args[nworkers];
+        struct timespec start;
+        
+        if (flight_queue_init(&queue, &schedule) != 0 ||
+            (partitioned && flight_queue_split(&queue, terminal_queues) != 0)) {
+            printf("Cannot queue %zu flights\n", schedule.count);
+            return 1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int i = 0; i < nworkers; i++) {
+            int t = partitioned ? i / TERMINAL_WORKERS : -1;
+            worker_args[i].queue = t < 0 ? &queue : &terminal_queues[t];
+            worker_args[i].terminal = t;
+            pthread_create(&workers[i], NULL, schedule_worker, &worker_args[i]);
+        }
+        for (int i = 0; i < nworkers; i++) {
+            pthread_join(workers[i], NULL);
+        }
+        printf("Replayed %zu flights in %.1f ms\n", queue.count, elapsed_ms(&start));
+        free(queue.rows);
+        for (int t = 0; partitioned && t < NUM_TERMINALS; t++) {
+            free(terminal_queues[t].rows);
+        }
+    } else {
+        // Create flight threads with slab-allocated parameters
+        int launched = 0;
+        for (int i = 0; i < NUM_FLIGHTS; i++) {
+            int flight_id = shard_id * NUM_FLIGHTS + (i + 1);
+            int* flight_params = slab_alloc(&flight_records);
+            if (!flight_params) {
+                // No record, no flight thread; it still counts as a flight
+                printf("Out of memory for Flight FL%d's record\n", flight_id);
+                divert_flight(flight_id);
+                settle_flight();
+                continue;
+            }
+            *flight_params = flight_id;
+            *flight_params |= ((rand() % 2) << 8);
+            *flight_params |= (((i % 4) == 0) << 9);
+            
+            pthread_create(&flights[launched++], NULL, flight_thread_safe, flight_params);
+            usleep(200000); // Stagger arrivals
+        }
         
-        pthread_create(&flights[i], NULL, flight_thread_safe, flight_params);
-        usleep(200000); // Stagger arrivals
+        // Wait for flights
+        for (int i = 0; i < launched; i++) {
+            pthread_join(flights[i], NULL);
+        }
     }
     
-    // Wait for flights
-    for (int i = 0; i < NUM_FLIGHTS; i++) {
-        pthread_join(flights[i], NULL);
+    // Handed-over flights keep arriving until the whole network is done
+    if (num_shards > 1) {
+        for (int w = 0; w < HANDOFF_WORKERS; w++) {
+            pthread_join(inbox[w], NULL);
+        }
     }
     
     // Cleanup
-    pthread_cancel(time_thread);
+    stop_time_simulator(time_thread);
     
     printf("\n===============================================\n");
     printf("FINAL RESULTS (SYNCHRONIZED)\n");
@@ -382,30 +1389,63 @@ int main() {
     printf("Flights served + diverted = %d + %d = %d\n",
            total_flights_served, flights_diverted,
            total_flights_served + flights_diverted);
-    printf("Expected total flights: %d\n", NUM_FLIGHTS);
+    printf("Expected total flights: %d\n", expected_flights);
+    
+    long handed_out = 0, received = 0;
+    if (num_shards > 1) {
+        handed_out = atomic_load(&network->shards[shard_id].handed_out);
+        received = atomic_load(&network->shards[shard_id].received);
+        printf("Handed off to airport %d: %ld, received from airport %d: %ld\n",
+               (shard_id + 1) % num_shards, handed_out,
+               (shard_id + num_shards - 1) % num_shards, received);
+    }
     
-    if (total_flights_served + flights_diverted == NUM_FLIGHTS) {
+    bool consistent = total_flights_served + flights_diverted + handed_out == expected_flights + received;
+    if (consistent) {
         printf("✓ STATISTICS CONSISTENT!\n");
     }
+    if (num_shards > 1) {
+        ShardReport* report = &network->shards[shard_id];
+        report->served = total_flights_served;
+        report->diverted = flights_diverted;
+        report->elapsed_ms = elapsed_ms(&run_start);
+        report->consistent = consistent && occupied_count == 0;
+    }
     
     if (occupied_count == 0) {
         printf("✓ ALL GATES PROPERLY RELEASED!\n");
     }
     pthread_mutex_unlock(&stats_mutex);
     
-    // Cleanup synchronization primitives
-    for (int i = 0; i < NUM_GATES; i++) {
-        pthread_mutex_destroy(&airport[i].gate_mutex);
-        sem_destroy(&airport[i].gate_sem);
+    if (partitioned) {
+        printf("\nTerminals (home-first, stealing when exhausted):\n");
+        for (int t = 0; t < NUM_TERMINALS; t++) {
+            printf("Terminal %c: %d gates, %d served from home, %d taken in from other terminals\n",
+                   terminals[t].name, terminals[t].num_gates,
+                   atomic_load(&terminals[t].served_local), atomic_load(&terminals[t].stolen));
+        }
     }
     
-    pthread_mutex_destroy(&airport_mutex);
-    pthread_mutex_destroy(&stats_mutex);
-    pthread_mutex_destroy(&time_mutex);
-    sem_destroy(&available_gates);
-    pthread_cond_destroy(&emergency_cond);
+    if (replay) flight_schedule_free(&schedule);
+    if (num_shards > 1) handoff->destroy(handoff);
+    
+    SlabStats records;
+    slab_stats(&flight_records, &records);
+    if (replay || use_tasks) {
+        printf("\nFlight records: none; only synthesized flights flown as threads take one\n");
+    } else {
+        printf("\nFlight records (one per flight thread): %lu allocated, %lu freed "
+               "(%lu by another thread), %lu live\n",
+               records.allocs, records.frees, records.remote_frees, records.live);
+    }
+    printf("Slab: %lu chunk(s), %zu KB reserved; process RSS %ld KB\n",
+           records.chunks, records.reserved_bytes / 1024, slab_rss_kb());
+    
+    // Cleanup synchronization primitives
+    cleanup_airport_sync();
     
     printf("\n✓ ALL SYNCHRONIZATION PRIMITIVES CLEANED UP\n");
     
     return 0;
 }
+#endif
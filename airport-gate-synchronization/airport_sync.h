@@ -0,0 +1,31 @@
+/*
+ * File: airport_sync.h
+ * Gate assignment entry points of airport_sync.c for code linking it as a
+ * library (build it with -DAIRPORT_SYNC_NO_MAIN), e.g. bench/bench.c.
+ */
+
+#ifndef AIRPORT_SYNC_H
+#define AIRPORT_SYNC_H
+
+#include <stdbool.h>
+
+typedef enum { DOMESTIC, INTERNATIONAL } FlightType;
+
+// Per-flight messages; off by default during a trace replay
+extern bool verbose_log;
+
+// Gates, locks, timers and statistics; call once before anything else.
+// Exits if the flight record cache cannot be set up.
+void init_airport_sync(void);
+// Destroys them again; init_airport_sync may then start a fresh airport
+void cleanup_airport_sync(void);
+
+// Takes a gate for one flight (through the terminal pools when
+// partitioned). Returns the gate index, or -1 if none is suitable.
+int take_gate(FlightType flight_type, int flight_id, bool is_emergency,
+              int arrival_time, int turnaround_hours);
+
+// Releases a gate taken by take_gate; a no-op if the flight no longer holds it
+void release_gate_safe(int gate_index, int flight_id);
+
+#endif
@@ -0,0 +1,410 @@
+/*
+ * File: flight_schedule.c
+ * Parallel CSV trace parser, binary trace mapper and writer.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "flight_schedule.h"
+
+_Static_assert(sizeof(FlightScheduleHeader) == FLIGHT_SCHEDULE_ALIGN, "header fills one aligned block");
+
+static uint64_t align_up(uint64_t x) {
+    return (x + FLIGHT_SCHEDULE_ALIGN - 1) & ~(uint64_t)(FLIGHT_SCHEDULE_ALIGN - 1);
+}
+
+// Column offsets relative to the start of the block holding them
+static void layout(FlightScheduleHeader* h, uint64_t count) {
+    memset(h, 0, sizeof(*h));
+    h->magic = FLIGHT_SCHEDULE_MAGIC;
+    h->version = FLIGHT_SCHEDULE_VERSION;
+    h->count = count;
+    h->flight_id_offset = sizeof(FlightScheduleHeader);
+    h->arrival_offset = align_up(h->flight_id_offset + count * sizeof(int32_t));
+    h->turnaround_offset = align_up(h->arrival_offset + count * sizeof(int32_t));
+    h->flags_offset = align_up(h->turnaround_offset + count);
+    h->file_size = align_up(h->flags_offset + count);
+}
+
+static bool in_arrival_order(const FlightSchedule* sched) {
+    for (size_t k = 1; k < sched->count; k++) {
+        if (sched->arrival[k] < sched->arrival[k - 1]) return false;
+    }
+    return true;
+}
+
+static void bind_columns(FlightSchedule* sched, const FlightScheduleHeader* h, char* base) {
+    sched->count = h->count;
+    sched->flight_id = (int32_t*)(base + h->flight_id_offset);
+    sched->arrival = (int32_t*)(base + h->arrival_offset);
+    sched->turnaround = (uint8_t*)(base + h->turnaround_offset);
+    sched->flags = (uint8_t*)(base + h->flags_offset);
+}
+
+// Every line but a blank one or a '#' comment must hold a flight
+static bool is_row(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    return p < end && *p != '#';
+}
+
+static const char* line_end(const char* p, const char* end) {
+    const char* nl = memchr(p, '\n', end - p);
+    return nl ? nl : end;
+}
+
+// One chunk of the mapped CSV, [begin, end) starting at a line boundary
+typedef struct {
+    const char* begin;
+    const char* end;
+    size_t rows;            // pass 1: rows in chunk
+    long lines;             // pass 1: lines in chunk
+    size_t first;           // pass 2: index of the chunk's first row
+    long first_line;        // pass 2: line number of the chunk's first line
+    FlightSchedule* sched;
+    size_t malformed;       // pass 2: rows that failed to parse
+    const char* error;      // first of them, NULL if none
+    long error_line;
+} ParseChunk;
+
+static void* count_rows(void* arg) {
+    ParseChunk* c = arg;
+    const char* p = c->begin;
+    c->rows = 0;
+    c->lines = 0;
+    while (p < c->end) {
+        const char* e = line_end(p, c->end);
+        if (is_row(p, e)) c->rows++;
+        c->lines++;
+        p = e + 1;
+    }
+    return NULL;
+}
+
+static bool parse_int(const char** pp, const char* end, long* out) {
+    const char* p = *pp;
+    long v = 0;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p >= end || *p < '0' || *p > '9') return false;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        if (v > INT32_MAX) return false;
+        p++;
+    }
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    *pp = p;
+    *out = v;
+    return true;
+}
+
+static bool parse_flag(const char** pp, const char* end, const char* yes, const char* no, bool* out) {
+    const char* p = *pp;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p >= end) return false;
+    if (strchr(yes, *p)) *out = true;
+    else if (strchr(no, *p)) *out = false;
+    else return false;
+    p++;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    *pp = p;
+    return true;
+}
+
+static bool expect_comma(const char** pp, const char* end) {
+    if (*pp >= end || **pp != ',') return false;
+    (*pp)++;
+    return true;
+}
+
+static bool parse_row(const char* p, const char* end, FlightSchedule* s, size_t row) {
+    long id, arrival, turnaround;
+    bool international, emergency;
+
+    if (end > p && end[-1] == '\r') end--;
+    if (!parse_int(&p, end, &id) || !expect_comma(&p, end) ||
+        !parse_flag(&p, end, "Ii1", "Dd0", &international) || !expect_comma(&p, end) ||
+        !parse_flag(&p, end, "Yy1", "Nn0", &emergency) || !expect_comma(&p, end) ||
+        !parse_int(&p, end, &arrival) || !expect_comma(&p, end) ||
+        !parse_int(&p, end, &turnaround) || p != end || turnaround > UINT8_MAX) {
+        return false;
+    }
+
+    s->flight_id[row] = (int32_t)id;
+    s->arrival[row] = (int32_t)arrival;
+    s->turnaround[row] = (uint8_t)turnaround;
+    s->flags[row] = (international ? FLIGHT_INTERNATIONAL : 0) | (emergency ? FLIGHT_EMERGENCY : 0);
+    return true;
+}
+
+// A malformed row keeps its slot (zeroed) so the rest of the chunk still
+// parses and every bad line is counted
+static void* parse_rows(void* arg) {
+    ParseChunk* c = arg;
+    const char* p = c->begin;
+    size_t row = c->first;
+    long line = c->first_line;
+    c->malformed = 0;
+    c->error = NULL;
+    while (p < c->end) {
+        const char* e = line_end(p, c->end);
+        if (is_row(p, e)) {
+            if (!parse_row(p, e, c->sched, row) && c->malformed++ == 0) {
+                c->error = p;
+                c->error_line = line;
+            }
+            row++;
+        }
+        line++;
+        p = e + 1;
+    }
+    return NULL;
+}
+
+// Start of the rows: past leading blank and comment lines, and past the
+// header if the first other line is not a flight. *line gets its line number.
+static const char* skip_header(const char* data, const char* end, long* line) {
+    const char* p = data;
+    *line = 1;
+    while (p < end) {
+        const char* e = line_end(p, end);
+        if (is_row(p, e)) {
+            const char* q = p;
+            while (q < e && (*q == ' ' || *q == '\t')) q++;
+            if (*q >= '0' && *q <= '9') return p;
+            (*line)++;
+            return e + 1 < end ? e + 1 : end;
+        }
+        (*line)++;
+        p = e + 1;
+    }
+    return end;
+}
+
+// Runs fn over every chunk, one thread per chunk (the first on the caller)
+static void run_chunks(ParseChunk* chunks, int n, void* (*fn)(void*)) {
+    pthread_t tids[n];
+    bool started[n];
+    for (int t = 1; t < n; t++) {
+        started[t] = pthread_create(&tids[t], NULL, fn, &chunks[t]) == 0;
+        if (!started[t]) fn(&chunks[t]);
+    }
+    fn(&chunks[0]);
+    for (int t = 1; t < n; t++) {
+        if (started[t]) pthread_join(tids[t], NULL);
+    }
+}
+
+static int load_csv(const char* data, size_t size, FlightSchedule* sched, int threads,
+                    FlightScheduleError* error) {
+    const char* end = data + size;
+    long line;
+    const char* body = skip_header(data, end, &line);
+    size = end - body;
+
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if ((size_t)threads > size / 4096 + 1) threads = (int)(size / 4096 + 1); // small files: fewer chunks
+
+    // Split at line boundaries
+    ParseChunk chunks[threads];
+    const char* p = body;
+    for (int t = 0; t < threads; t++) {
+        const char* cut = t == threads - 1 ? end : body + size / threads * (t + 1);
+        if (cut < p) cut = p;
+        if (cut < end) cut = line_end(cut, end);
+        if (cut < end) cut++;
+        chunks[t].begin = p;
+        chunks[t].end = cut;
+        chunks[t].sched = sched;
+        p = cut;
+    }
+
+    run_chunks(chunks, threads, count_rows);
+
+    size_t total = 0;
+    for (int t = 0; t < threads; t++) {
+        chunks[t].first = total;
+        chunks[t].first_line = line;
+        total += chunks[t].rows;
+        line += chunks[t].lines;
+    }
+
+    // Every column in one allocation, same layout as the binary format
+    FlightScheduleHeader h;
+    layout(&h, total);
+    char* storage = aligned_alloc(FLIGHT_SCHEDULE_ALIGN, h.file_size);
+    if (!storage) return -1;
+    memcpy(storage, &h, sizeof(h));
+    bind_columns(sched, &h, storage);
+    sched->storage = storage;
+    sched->storage_size = h.file_size;
+    sched->mapped = false;
+
+    run_chunks(chunks, threads, parse_rows);
+
+    for (int t = 0; t < threads; t++) {
+        if (chunks[t].malformed == 0) continue;
+        if (error && error->malformed == 0) {
+            error->line = chunks[t].error_line;
+            error->offset = (long)(chunks[t].error - data);
+        }
+        if (error) error->malformed += chunks[t].malformed;
+    }
+    if (error && error->malformed > 0) {
+        free(storage);
+        memset(sched, 0, sizeof(*sched));
+        return -1;
+    }
+    sched->sorted = in_arrival_order(sched);
+    return 0;
+}
+
+int flight_schedule_load(const char* path, FlightSchedule* sched, int threads, FlightScheduleError* error) {
+    struct stat st;
+    FlightScheduleError local;
+    if (!error) error = &local;
+    memset(error, 0, sizeof(*error));
+    memset(sched, 0, sizeof(*sched));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+
+    const FlightScheduleHeader* h = data;
+    if ((size_t)st.st_size >= sizeof(*h) && h->magic == FLIGHT_SCHEDULE_MAGIC) {
+        // Every column must be where the count puts it, inside the file
+        FlightScheduleHeader expect;
+        layout(&expect, h->count <= (uint64_t)st.st_size ? h->count : 0);
+        if (h->version != FLIGHT_SCHEDULE_VERSION || h->count > (uint64_t)st.st_size ||
+            expect.file_size != (uint64_t)st.st_size || h->file_size != expect.file_size ||
+            h->flight_id_offset != expect.flight_id_offset || h->arrival_offset != expect.arrival_offset ||
+            h->turnaround_offset != expect.turnaround_offset || h->flags_offset != expect.flags_offset) {
+            munmap(data, st.st_size);
+            return -1;
+        }
+        // Binary trace: used straight from the mapping
+        bind_columns(sched, h, data);
+        sched->storage = data;
+        sched->storage_size = st.st_size;
+        sched->mapped = true;
+        sched->sorted = (h->attributes & FLIGHT_SCHEDULE_SORTED) != 0;
+        return 0;
+    }
+
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    int rc = load_csv(data, st.st_size, sched, threads, error);
+    munmap(data, st.st_size);
+    return rc;
+}
+
+void flight_schedule_free(FlightSchedule* sched) {
+    if (sched->mapped) munmap(sched->storage, sched->storage_size);
+    else free(sched->storage);
+    sched->storage = NULL;
+    sched->count = 0;
+}
+
+static int write_all(int fd, const void* buf, size_t len) {
+    const char* p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int by_arrival(const void* a, const void* b, void* ctx) {
+    const FlightSchedule* sched = ctx;
+    size_t x = *(const size_t*)a, y = *(const size_t*)b;
+    if (sched->arrival[x] != sched->arrival[y]) return sched->arrival[x] < sched->arrival[y] ? -1 : 1;
+    return x < y ? -1 : x > y;
+}
+
+// A copy of sched with its rows in arrival order, for writing
+static int sort_by_arrival(const FlightSchedule* sched, FlightSchedule* out) {
+    FlightScheduleHeader h;
+    layout(&h, sched->count);
+    size_t* order = malloc((sched->count + 1) * sizeof(size_t));
+    char* storage = aligned_alloc(FLIGHT_SCHEDULE_ALIGN, h.file_size);
+    if (!order || !storage) {
+        free(order);
+        free(storage);
+        return -1;
+    }
+    for (size_t k = 0; k < sched->count; k++) order[k] = k;
+    qsort_r(order, sched->count, sizeof(size_t), by_arrival, (void*)sched);
+
+    memset(out, 0, sizeof(*out));
+    bind_columns(out, &h, storage);
+    for (size_t n = 0; n < sched->count; n++) {
+        size_t k = order[n];
+        out->flight_id[n] = sched->flight_id[k];
+        out->arrival[n] = sched->arrival[k];
+        out->turnaround[n] = sched->turnaround[k];
+        out->flags[n] = sched->flags[k];
+    }
+    free(order);
+    out->storage = storage;
+    out->storage_size = h.file_size;
+    out->sorted = true;
+    return 0;
+}
+
+int flight_schedule_write(const FlightSchedule* sched, const char* path) {
+    char tmp[4096];
+    FlightScheduleHeader h;
+    FlightSchedule sorted;
+    static const char zeros[FLIGHT_SCHEDULE_ALIGN];
+
+    if (!in_arrival_order(sched)) {
+        if (sort_by_arrival(sched, &sorted) != 0) return -1;
+        int rc = flight_schedule_write(&sorted, path);
+        flight_schedule_free(&sorted);
+        return rc;
+    }
+    layout(&h, sched->count);
+    h.attributes = FLIGHT_SCHEDULE_SORTED;
+
+    struct { uint64_t offset; const void* data; size_t bytes; } cols[] = {
+        { h.flight_id_offset, sched->flight_id, sched->count * sizeof(int32_t) },
+        { h.arrival_offset, sched->arrival, sched->count * sizeof(int32_t) },
+        { h.turnaround_offset, sched->turnaround, sched->count },
+        { h.flags_offset, sched->flags, sched->count },
+    };
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+
+    uint64_t pos = sizeof(h);
+    int rc = write_all(fd, &h, sizeof(h));
+    for (size_t c = 0; rc == 0 && c < sizeof(cols) / sizeof(cols[0]); c++) {
+        rc = write_all(fd, zeros, cols[c].offset - pos);
+        if (rc == 0) rc = write_all(fd, cols[c].data, cols[c].bytes);
+        pos = cols[c].offset + cols[c].bytes;
+    }
+    if (rc == 0) rc = write_all(fd, zeros, h.file_size - pos);
+    if (rc == 0) rc = fsync(fd);
+    close(fd);
+    if (rc == 0) rc = rename(tmp, path);
+    if (rc != 0) unlink(tmp);
+    return rc == 0 ? 0 : -1;
+}
@@ -0,0 +1,78 @@
+/*
+ * File: flight_schedule.h
+ * Columnar flight schedule loaded from a trace file.
+ *
+ * CSV trace, one flight per line:
+ *   flight_id,type,emergency,arrival_hour,turnaround_hours
+ *   type is D/I (or 0/1), emergency is 0/1 (or N/Y)
+ * Blank lines and '#' comments are skipped, and so is a header: the first
+ * other line, if it does not start with a digit. Every remaining line must
+ * be a flight.
+ *
+ * Binary trace (written by flight_schedule_write), mapped and used in place:
+ *   FlightScheduleHeader, then the columns, each aligned to 64 bytes
+ *   Rows are written in arrival order, so a replay never has to sort them.
+ *
+ * The schedule is never turned into per-flight heap objects: a CSV is
+ * mapped, split into chunks parsed in parallel, and stored as one
+ * allocation holding every column.
+ */
+
+#ifndef FLIGHT_SCHEDULE_H
+#define FLIGHT_SCHEDULE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define FLIGHT_SCHEDULE_MAGIC   0x53544c46u  // "FLTS"
+#define FLIGHT_SCHEDULE_VERSION 1
+#define FLIGHT_SCHEDULE_ALIGN   64
+
+#define FLIGHT_INTERNATIONAL 0x1
+#define FLIGHT_EMERGENCY     0x2
+
+#define FLIGHT_SCHEDULE_SORTED 0x1  // header attributes: rows in arrival order
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+    uint64_t flight_id_offset;
+    uint64_t arrival_offset;
+    uint64_t turnaround_offset;
+    uint64_t flags_offset;
+    uint64_t file_size;
+    uint32_t attributes;
+    uint8_t reserved[4];
+} FlightScheduleHeader;
+
+typedef struct {
+    size_t count;
+    int32_t* flight_id;
+    int32_t* arrival;       // absolute simulated hour, multi-day traces exceed 24
+    uint8_t* turnaround;    // hours
+    uint8_t* flags;         // FLIGHT_INTERNATIONAL | FLIGHT_EMERGENCY
+    void* storage;          // owning allocation or mapping
+    size_t storage_size;
+    bool mapped;
+    bool sorted;            // arrival never decreases from one row to the next
+} FlightSchedule;
+
+// Where a CSV trace went wrong
+typedef struct {
+    size_t malformed;       // lines that are not a valid flight, 0 for any other failure
+    long line;              // 1-based line number of the first of them
+    long offset;            // and its byte offset
+} FlightScheduleError;
+
+// Loads a binary or CSV trace (detected by magic). threads <= 0 uses every
+// online core. Returns 0, or -1 with *error filled in (may be NULL).
+int flight_schedule_load(const char* path, FlightSchedule* sched, int threads, FlightScheduleError* error);
+void flight_schedule_free(FlightSchedule* sched);
+
+// Writes sched in the binary format (temp file + rename), rows sorted by
+// arrival; flights with the same arrival keep their trace order
+int flight_schedule_write(const FlightSchedule* sched, const char* path);
+
+#endif
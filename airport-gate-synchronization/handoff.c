@@ -0,0 +1,199 @@
+/*
+ * File: handoff.c
+ * Shared-memory queue and Unix-socket transports for flight handoff.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include "handoff.h"
+
+uint64_t handoff_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Shared-memory queue
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    unsigned head;
+    unsigned count;
+    HandoffMsg slots[HANDOFF_QUEUE_SLOTS];
+} HandoffQueue;
+
+typedef struct {
+    HandoffTransport base;
+    HandoffQueue* inboxes;   // One per shard, in a MAP_SHARED mapping
+    size_t size;
+    pid_t owner;
+} QueueTransport;
+
+static int queue_send(HandoffTransport* t, int shard, const HandoffMsg* msg, bool block) {
+    HandoffQueue* q = &((QueueTransport*)t)->inboxes[shard];
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == HANDOFF_QUEUE_SLOTS) {
+        if (!block) {
+            pthread_mutex_unlock(&q->lock);
+            return -1;
+        }
+        pthread_cond_wait(&q->not_full, &q->lock);
+    }
+    q->slots[(q->head + q->count) % HANDOFF_QUEUE_SLOTS] = *msg;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+static int queue_recv(HandoffTransport* t, int shard, HandoffMsg* msg) {
+    HandoffQueue* q = &((QueueTransport*)t)->inboxes[shard];
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0) {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+    *msg = q->slots[q->head];
+    q->head = (q->head + 1) % HANDOFF_QUEUE_SLOTS;
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+static void queue_destroy(HandoffTransport* t) {
+    QueueTransport* qt = (QueueTransport*)t;
+
+    if (getpid() == qt->owner) {
+        for (int s = 0; s < t->shards; s++) {
+            pthread_mutex_destroy(&qt->inboxes[s].lock);
+            pthread_cond_destroy(&qt->inboxes[s].not_empty);
+            pthread_cond_destroy(&qt->inboxes[s].not_full);
+        }
+    }
+    munmap(qt->inboxes, qt->size);
+    free(qt);
+}
+
+static HandoffTransport* queue_create(int shards) {
+    QueueTransport* qt = calloc(1, sizeof(*qt));
+    if (!qt) return NULL;
+
+    qt->size = (size_t)shards * sizeof(HandoffQueue);
+    qt->inboxes = mmap(NULL, qt->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (qt->inboxes == MAP_FAILED) {
+        free(qt);
+        return NULL;
+    }
+
+    pthread_mutexattr_t ma;
+    pthread_condattr_t ca;
+    pthread_mutexattr_init(&ma);
+    pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_init(&ca);
+    pthread_condattr_setpshared(&ca, PTHREAD_PROCESS_SHARED);
+    for (int s = 0; s < shards; s++) {
+        pthread_mutex_init(&qt->inboxes[s].lock, &ma);
+        pthread_cond_init(&qt->inboxes[s].not_empty, &ca);
+        pthread_cond_init(&qt->inboxes[s].not_full, &ca);
+    }
+    pthread_mutexattr_destroy(&ma);
+    pthread_condattr_destroy(&ca);
+
+    qt->owner = getpid();
+    qt->base.name = "queue";
+    qt->base.shards = shards;
+    qt->base.send = queue_send;
+    qt->base.recv = queue_recv;
+    qt->base.destroy = queue_destroy;
+    return &qt->base;
+}
+
+// ---------------------------------------------------------------------------
+// Unix sockets: inbox s reads fds[s][0], every sender writes fds[s][1].
+// SOCK_SEQPACKET keeps message boundaries, so concurrent readers and
+// writers each move whole messages.
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    HandoffTransport base;
+    int (*fds)[2];
+} SocketTransport;
+
+static int socket_send(HandoffTransport* t, int shard, const HandoffMsg* msg, bool block) {
+    int fd = ((SocketTransport*)t)->fds[shard][1];
+    ssize_t n;
+
+    do {
+        n = send(fd, msg, sizeof(*msg), block ? 0 : MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    return n == (ssize_t)sizeof(*msg) ? 0 : -1;
+}
+
+static int socket_recv(HandoffTransport* t, int shard, HandoffMsg* msg) {
+    int fd = ((SocketTransport*)t)->fds[shard][0];
+    ssize_t n;
+
+    do {
+        n = recv(fd, msg, sizeof(*msg), 0);
+    } while (n < 0 && errno == EINTR);
+    return n == (ssize_t)sizeof(*msg) ? 0 : -1;
+}
+
+static void socket_destroy(HandoffTransport* t) {
+    SocketTransport* st = (SocketTransport*)t;
+
+    for (int s = 0; s < t->shards; s++) {
+        close(st->fds[s][0]);
+        close(st->fds[s][1]);
+    }
+    free(st->fds);
+    free(st);
+}
+
+static HandoffTransport* socket_create(int shards) {
+    SocketTransport* st = calloc(1, sizeof(*st));
+    if (!st) return NULL;
+    st->fds = calloc(shards, sizeof(*st->fds));
+    if (!st->fds) {
+        free(st);
+        return NULL;
+    }
+
+    for (int s = 0; s < shards; s++) {
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, st->fds[s]) != 0) {
+            while (--s >= 0) {
+                close(st->fds[s][0]);
+                close(st->fds[s][1]);
+            }
+            free(st->fds);
+            free(st);
+            return NULL;
+        }
+    }
+
+    st->base.name = "unix";
+    st->base.shards = shards;
+    st->base.send = socket_send;
+    st->base.recv = socket_recv;
+    st->base.destroy = socket_destroy;
+    return &st->base;
+}
+
+HandoffTransport* handoff_transport_create(const char* kind, int shards) {
+    if (shards <= 0) return NULL;
+    if (strcmp(kind, "queue") == 0) return queue_create(shards);
+    if (strcmp(kind, "unix") == 0) return socket_create(shards);
+    return NULL;
+}
@@ -0,0 +1,57 @@
+/*
+ * File: handoff.h
+ * Cross-airport flight handoff over a pluggable transport.
+ *
+ * An airport that cannot place a flight passes it to a neighbour as one
+ * fixed-size message. Each airport (shard) owns one inbox:
+ *   "queue" - bounded ring with process-shared mutex/conds in a shared
+ *             mapping; works between threads or between forked shards
+ *   "unix"  - one SOCK_SEQPACKET socket pair per inbox, the local
+ *             stand-in for a network link between nodes
+ * Create the transport before forking the shards so they all inherit it.
+ */
+
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HANDOFF_QUEUE_SLOTS 256
+
+// Message kinds; a stop carries no flight, so any flight_id can be handed off
+#define HANDOFF_FLIGHT 0
+#define HANDOFF_STOP 1       // Stops one inbox worker
+
+typedef struct {
+    int32_t flight_id;
+    uint8_t type;            // FlightType
+    uint8_t emergency;
+    uint8_t hops;            // Airports that have already turned the flight away
+    uint8_t from;            // Sending shard
+    uint8_t kind;            // HANDOFF_FLIGHT or HANDOFF_STOP
+    int32_t arrival;         // Hour
+    int32_t turnaround;      // Hours
+    int32_t turnaround_us;   // Real time to hold the gate
+    uint64_t sent_ns;        // CLOCK_MONOTONIC at send, for handoff latency
+} HandoffMsg;
+
+typedef struct HandoffTransport HandoffTransport;
+
+struct HandoffTransport {
+    const char* name;
+    int shards;
+    // 0 on success; -1 when the inbox is full and block is false
+    int (*send)(HandoffTransport* t, int shard, const HandoffMsg* msg, bool block);
+    // Waits for the next message in shard's inbox; 0 on success
+    int (*recv)(HandoffTransport* t, int shard, HandoffMsg* msg);
+    // Releases this process's handle; the creating process also tears down the inboxes
+    void (*destroy)(HandoffTransport* t);
+};
+
+// kind is "queue" or "unix"; NULL on an unknown kind or failure
+HandoffTransport* handoff_transport_create(const char* kind, int shards);
+
+uint64_t handoff_now_ns(void);
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * File: seqlock.h
+ * Sequence counter for single-writer / many-reader publication.
+ * Writers are already serialized by their own mutex; readers never block
+ * them, they just retry if a write overlapped their read. Published
+ * fields must be atomics accessed with relaxed ordering so a torn read is
+ * detected rather than being a data race.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+typedef struct {
+    atomic_uint seq;   // odd while a write is in progress
+} SeqCount;
+
+static inline void seq_init(SeqCount* s) {
+    atomic_init(&s->seq, 0);
+}
+
+static inline void seq_write_begin(SeqCount* s) {
+    unsigned v = atomic_load_explicit(&s->seq, memory_order_relaxed);
+    atomic_store_explicit(&s->seq, v + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void seq_write_end(SeqCount* s) {
+    unsigned v = atomic_load_explicit(&s->seq, memory_order_relaxed);
+    atomic_store_explicit(&s->seq, v + 1, memory_order_release);
+}
+
+// Spins only while a writer is mid-update (a handful of stores)
+static inline unsigned seq_read_begin(SeqCount* s) {
+    unsigned v;
+    while ((v = atomic_load_explicit(&s->seq, memory_order_acquire)) & 1) {
+    }
+    return v;
+}
+
+static inline bool seq_read_retry(SeqCount* s, unsigned start) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&s->seq, memory_order_relaxed) != start;
+}
+
+#endif
@@ -0,0 +1,232 @@
+/*
+ * File: slab.c
+ * Per-thread heaps, chunk carving and remote free lists for slab.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "slab.h"
+
+struct SlabChunk {
+    SlabHeap* owner;
+    SlabChunk* next;             // In the owner's list or the cache's spare list
+} __attribute__((aligned(SLAB_ALIGN)));
+
+struct SlabHeap {
+    SlabCache* cache;
+    SlabHeap* next;              // Registry link
+    void* local;                 // Owner-only free list
+    _Atomic(void*) remote;       // Records freed by other threads
+    SlabChunk* chunks;
+    char* bump;                  // Uncarved part of the newest chunk
+    char* bump_end;
+    atomic_bool abandoned;       // Thread exited; free for adoption
+    atomic_ulong allocs;         // Written by the owner only
+    atomic_ulong frees;
+    atomic_ulong remote_frees;   // Written by other threads
+} __attribute__((aligned(64)));
+
+// The free-list link lives in the first word of a free record
+#define NEXT_FREE(p) (*(void**)(p))
+
+static SlabChunk* chunk_of(void* ptr) {
+    return (SlabChunk*)((uintptr_t)ptr & ~(uintptr_t)(SLAB_CHUNK_SIZE - 1));
+}
+
+static void heap_abandon(void* arg) {
+    SlabHeap* heap = arg;
+    atomic_store(&heap->abandoned, true);
+}
+
+// Adopt a heap left by an exited thread, or register a new one
+static SlabHeap* heap_for_thread(SlabCache* cache) {
+    SlabHeap* heap;
+
+    pthread_mutex_lock(&cache->lock);
+    for (heap = cache->heaps; heap; heap = heap->next) {
+        if (atomic_load(&heap->abandoned)) {
+            atomic_store(&heap->abandoned, false);
+            break;
+        }
+    }
+    if (!heap) {
+        heap = aligned_alloc(64, sizeof(SlabHeap));
+        if (heap) {
+            heap->cache = cache;
+            heap->local = NULL;
+            atomic_init(&heap->remote, NULL);
+            heap->chunks = NULL;
+            heap->bump = heap->bump_end = NULL;
+            atomic_init(&heap->abandoned, false);
+            atomic_init(&heap->allocs, 0);
+            atomic_init(&heap->frees, 0);
+            atomic_init(&heap->remote_frees, 0);
+            heap->next = cache->heaps;
+            cache->heaps = heap;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    if (heap) pthread_setspecific(cache->key, heap);
+    return heap;
+}
+
+// Give the heap a fresh chunk to carve: a spare one if any, else a new one
+static bool heap_refill(SlabHeap* heap) {
+    SlabCache* cache = heap->cache;
+    SlabChunk* chunk;
+
+    pthread_mutex_lock(&cache->lock);
+    chunk = cache->spare;
+    if (chunk) cache->spare = chunk->next;
+    pthread_mutex_unlock(&cache->lock);
+
+    if (!chunk) {
+        chunk = aligned_alloc(SLAB_CHUNK_SIZE, SLAB_CHUNK_SIZE);
+        if (!chunk) return false;
+        atomic_fetch_add(&cache->chunks, 1);
+    }
+    chunk->owner = heap;
+    chunk->next = heap->chunks;
+    heap->chunks = chunk;
+    heap->bump = (char*)chunk + sizeof(SlabChunk);
+    heap->bump_end = (char*)chunk + SLAB_CHUNK_SIZE;
+    return true;
+}
+
+int slab_cache_init(SlabCache* cache, const char* name, size_t object_size) {
+    if (object_size < sizeof(void*)) object_size = sizeof(void*);
+    object_size = (object_size + SLAB_ALIGN - 1) & ~(size_t)(SLAB_ALIGN - 1);
+    if (object_size > SLAB_CHUNK_SIZE - sizeof(SlabChunk)) return -1;
+
+    if (pthread_key_create(&cache->key, heap_abandon) != 0) return -1;
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->name = name;
+    cache->object_size = object_size;
+    cache->heaps = NULL;
+    cache->spare = NULL;
+    atomic_init(&cache->chunks, 0);
+    atomic_init(&cache->dropped, 0);
+    return 0;
+}
+
+static void free_chunks(SlabChunk* chunk) {
+    while (chunk) {
+        SlabChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+void slab_cache_destroy(SlabCache* cache) {
+    SlabHeap* heap = cache->heaps;
+
+    while (heap) {
+        SlabHeap* next = heap->next;
+        free_chunks(heap->chunks);
+        free(heap);
+        heap = next;
+    }
+    free_chunks(cache->spare);
+    cache->heaps = NULL;
+    cache->spare = NULL;
+    pthread_key_delete(cache->key);
+    pthread_mutex_destroy(&cache->lock);
+}
+
+void* slab_alloc(SlabCache* cache) {
+    SlabHeap* heap = pthread_getspecific(cache->key);
+    void* ptr;
+
+    if (!heap && !(heap = heap_for_thread(cache))) return NULL;
+
+    if (!heap->local && atomic_load_explicit(&heap->remote, memory_order_relaxed)) {
+        // Take everything other threads have freed in one exchange
+        heap->local = atomic_exchange_explicit(&heap->remote, NULL, memory_order_acquire);
+    }
+    if (heap->local) {
+        ptr = heap->local;
+        heap->local = NEXT_FREE(ptr);
+    } else {
+        if (heap->bump + cache->object_size > heap->bump_end && !heap_refill(heap)) return NULL;
+        ptr = heap->bump;
+        heap->bump += cache->object_size;
+    }
+    atomic_store_explicit(&heap->allocs, atomic_load_explicit(&heap->allocs, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    return ptr;
+}
+
+void slab_free(void* ptr) {
+    if (!ptr) return;
+
+    SlabHeap* heap = chunk_of(ptr)->owner;
+    if (pthread_getspecific(heap->cache->key) == heap) {
+        NEXT_FREE(ptr) = heap->local;
+        heap->local = ptr;
+        atomic_store_explicit(&heap->frees, atomic_load_explicit(&heap->frees, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        return;
+    }
+
+    // Lock-free push; the owner only ever takes the whole list, so no ABA
+    void* head = atomic_load_explicit(&heap->remote, memory_order_relaxed);
+    do {
+        NEXT_FREE(ptr) = head;
+    } while (!atomic_compare_exchange_weak_explicit(&heap->remote, &head, ptr,
+                                                    memory_order_release, memory_order_relaxed));
+    atomic_fetch_add_explicit(&heap->remote_frees, 1, memory_order_relaxed);
+}
+
+void slab_reset(SlabCache* cache) {
+    SlabStats st;
+
+    slab_stats(cache, &st);
+    atomic_fetch_add(&cache->dropped, st.live);
+
+    pthread_mutex_lock(&cache->lock);
+    for (SlabHeap* heap = cache->heaps; heap; heap = heap->next) {
+        while (heap->chunks) {
+            SlabChunk* chunk = heap->chunks;
+            heap->chunks = chunk->next;
+            chunk->next = cache->spare;
+            cache->spare = chunk;
+        }
+        heap->local = NULL;
+        atomic_store(&heap->remote, NULL);
+        heap->bump = heap->bump_end = NULL;
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void slab_stats(SlabCache* cache, SlabStats* out) {
+    out->allocs = out->frees = out->remote_frees = 0;
+    out->heaps = 0;
+
+    pthread_mutex_lock(&cache->lock);
+    for (SlabHeap* heap = cache->heaps; heap; heap = heap->next) {
+        unsigned long remote = atomic_load_explicit(&heap->remote_frees, memory_order_relaxed);
+        out->allocs += atomic_load_explicit(&heap->allocs, memory_order_relaxed);
+        out->frees += atomic_load_explicit(&heap->frees, memory_order_relaxed) + remote;
+        out->remote_frees += remote;
+        out->heaps++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    unsigned long dropped = atomic_load(&cache->dropped);
+    out->live = out->allocs > out->frees + dropped ? out->allocs - out->frees - dropped : 0;
+    out->chunks = atomic_load(&cache->chunks);
+    out->reserved_bytes = out->chunks * (size_t)SLAB_CHUNK_SIZE;
+}
+
+long slab_rss_kb(void) {
+    FILE* f = fopen("/proc/self/statm", "r");
+    long size, resident;
+
+    if (!f) return -1;
+    int n = fscanf(f, "%ld %ld", &size, &resident);
+    fclose(f);
+    return n == 2 ? resident * (sysconf(_SC_PAGESIZE) / 1024) : -1;
+}
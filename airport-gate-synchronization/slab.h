@@ -0,0 +1,74 @@
+/*
+ * File: slab.h
+ * Per-thread slab allocator for fixed-size records (flights, events, log
+ * entries).
+ *
+ * One SlabCache per record type. Each thread allocates from its own heap:
+ * a private free list, then a bump pointer into a 64 KB chunk it owns, so
+ * the common path takes no lock and touches no shared cache line.
+ *   - slab_free from the owning thread pushes on its private list
+ *   - slab_free from any other thread pushes on the owner's remote list
+ *     (lock-free); the owner takes the whole list in one exchange when its
+ *     private list runs dry
+ * The owner of a record is found from its chunk, which is aligned to its
+ * size, so records carry no header.
+ *
+ * A heap whose thread exits is adopted by the next thread that needs one.
+ * slab_reset drops every record at once and keeps the chunks for the next
+ * run; it must only be called while no thread uses the cache.
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define SLAB_CHUNK_SIZE (64 * 1024)
+#define SLAB_ALIGN 16
+
+typedef struct SlabHeap SlabHeap;
+typedef struct SlabChunk SlabChunk;
+
+typedef struct {
+    const char* name;
+    size_t object_size;          // Rounded up to SLAB_ALIGN
+    pthread_key_t key;           // This thread's heap
+    pthread_mutex_t lock;        // Heap registry and spare chunks
+    SlabHeap* heaps;
+    SlabChunk* spare;            // Chunks returned by slab_reset
+    atomic_ulong chunks;         // Chunks ever taken from the system
+    atomic_ulong dropped;        // Live records discarded by slab_reset
+} SlabCache;
+
+typedef struct {
+    unsigned long allocs;
+    unsigned long frees;         // Including remote frees
+    unsigned long remote_frees;  // Freed by a thread other than the owner
+    unsigned long live;
+    unsigned long chunks;
+    size_t reserved_bytes;
+    int heaps;
+} SlabStats;
+
+// 0 on success, -1 if the object size does not fit a chunk or init fails
+int slab_cache_init(SlabCache* cache, const char* name, size_t object_size);
+// Frees every chunk; all records become invalid
+void slab_cache_destroy(SlabCache* cache);
+
+// NULL only when the system is out of memory
+void* slab_alloc(SlabCache* cache);
+// Any thread may free any record of any cache
+void slab_free(void* ptr);
+
+// Drop every record at once and keep the chunks (no thread may be using the cache)
+void slab_reset(SlabCache* cache);
+
+void slab_stats(SlabCache* cache, SlabStats* out);
+
+// Resident set size of the process in KB, -1 if unknown
+long slab_rss_kb(void);
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * File: timer_wheel.c
+ * Hierarchical timing wheel. A timer due in d ticks sits on the level
+ * whose slot span covers d; when a level's index wraps, the next level's
+ * current slot is cascaded down so no expiry can be skipped.
+ */
+
+#include "timer_wheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define MAX_DELAY ((1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+static void list_init(TimerNode* head) {
+    head->prev = head;
+    head->next = head;
+}
+
+static void list_add(TimerNode* head, TimerNode* node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+static void list_del(TimerNode* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = node;
+}
+
+void timer_wheel_init(TimerWheel* wheel) {
+    wheel->now = 0;
+    for (int l = 0; l < TIMER_WHEEL_LEVELS; l++) {
+        for (int s = 0; s < TIMER_WHEEL_SLOTS; s++) {
+            list_init(&wheel->slots[l][s]);
+        }
+    }
+}
+
+void timer_node_init(TimerNode* node) {
+    list_init(node);
+    node->expires = 0;
+    node->cookie = 0;
+    node->armed = false;
+}
+
+// Links node into the slot covering its expiry. A timer due on the current
+// tick (only reachable through a cascade) lands in the level-0 slot that
+// timer_wheel_tick is about to run.
+static void place(TimerWheel* wheel, TimerNode* node) {
+    uint64_t expires = node->expires;
+    if (expires < wheel->now) expires = wheel->now;
+
+    uint64_t delta = expires - wheel->now;
+    if (delta > MAX_DELAY) {
+        // Parked on the last level; re-placed when that slot cascades
+        delta = MAX_DELAY;
+        expires = wheel->now + MAX_DELAY;
+    }
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (1ULL << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    int slot = (expires >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK;
+    list_add(&wheel->slots[level][slot], node);
+}
+
+void timer_schedule(TimerWheel* wheel, TimerNode* node, uint64_t delay) {
+    if (node->armed) list_del(node);
+    node->expires = wheel->now + (delay ? delay : 1);
+    node->armed = true;
+    place(wheel, node);
+}
+
+void timer_cancel(TimerWheel* wheel, TimerNode* node) {
+    (void)wheel;
+    if (!node->armed) return;
+    list_del(node);
+    node->armed = false;
+}
+
+// Re-places every timer of one slot on a finer level
+static void cascade(TimerWheel* wheel, int level, int slot) {
+    TimerNode* head = &wheel->slots[level][slot];
+    TimerNode pending;
+
+    if (head->next == head) return;
+    // Detach the whole slot first, place() may link back into it
+    pending.next = head->next;
+    pending.prev = head->prev;
+    pending.next->prev = &pending;
+    pending.prev->next = &pending;
+    list_init(head);
+
+    while (pending.next != &pending) {
+        TimerNode* node = pending.next;
+        list_del(node);
+        place(wheel, node);
+    }
+}
+
+void timer_wheel_tick(TimerWheel* wheel, TimerFire fire, void* ctx) {
+    uint64_t now = ++wheel->now;
+
+    // Highest level whose lower indices all wrapped to zero on this tick
+    int top = 0;
+    while (top < TIMER_WHEEL_LEVELS - 1 &&
+           ((now >> (TIMER_WHEEL_BITS * top)) & SLOT_MASK) == 0) {
+        top++;
+    }
+    for (int level = top; level >= 1; level--) {
+        cascade(wheel, level, (now >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK);
+    }
+
+    TimerNode* head = &wheel->slots[0][now & SLOT_MASK];
+    while (head->next != head) {
+        TimerNode* node = head->next;
+        list_del(node);
+        if (node->expires > now) {
+            place(wheel, node); // parked beyond MAX_DELAY, not due yet
+            continue;
+        }
+        node->armed = false;
+        fire(node, ctx);
+    }
+}
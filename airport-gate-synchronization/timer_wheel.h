@@ -0,0 +1,45 @@
+/*
+ * File: timer_wheel.h
+ * Hierarchical timing wheel (4 levels x 64 slots) with intrusive timers.
+ * Scheduling and cancelling are O(1); a tick only touches the timers that
+ * expire on it plus an occasional cascade from a coarser level.
+ * Not thread-safe by itself: callers serialize access with their own lock.
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TIMER_WHEEL_BITS   6
+#define TIMER_WHEEL_SLOTS  (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+typedef struct TimerNode {
+    struct TimerNode* prev;
+    struct TimerNode* next;
+    uint64_t expires;   // absolute tick
+    unsigned cookie;    // caller data copied out on expiry (e.g. a generation)
+    bool armed;
+} TimerNode;
+
+typedef struct {
+    uint64_t now;
+    TimerNode slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS]; // list heads
+} TimerWheel;
+
+// Called for each expired timer; the node is already unlinked and disarmed
+typedef void (*TimerFire)(TimerNode* node, void* ctx);
+
+void timer_wheel_init(TimerWheel* wheel);
+void timer_node_init(TimerNode* node);
+
+// Arms (or re-arms) node to expire delay ticks from now; 0 means next tick
+void timer_schedule(TimerWheel* wheel, TimerNode* node, uint64_t delay);
+void timer_cancel(TimerWheel* wheel, TimerNode* node);
+
+// Advances the wheel by one tick and fires everything due on it
+void timer_wheel_tick(TimerWheel* wheel, TimerFire fire, void* ctx);
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * File: banker.c
+ * Banker's algorithm safety check without any I/O in the hot loop.
+ * Reporting happens only through the optional SafetyTrace callback.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "banker.h"
+
+int safety_result_init(SafetyResult* res, int processes, int resources, bool track_blocking) {
+    res->processes = processes;
+    res->resources = resources;
+    res->safe = false;
+    res->count = 0;
+    res->sequence = malloc(sizeof(int) * processes);
+    res->blocking = track_blocking ? malloc(sizeof(int) * processes) : NULL;
+    res->work = malloc(sizeof(int) * resources);
+    res->finish = malloc(sizeof(bool) * processes);
+
+    if (!res->sequence || !res->work || !res->finish ||
+        (track_blocking && !res->blocking)) {
+        safety_result_free(res);
+        return -1;
+    }
+    return 0;
+}
+
+void safety_result_free(SafetyResult* res) {
+    free(res->sequence);
+    free(res->blocking);
+    free(res->work);
+    free(res->finish);
+    res->sequence = NULL;
+    res->blocking = NULL;
+    res->work = NULL;
+    res->finish = NULL;
+}
+
+static void emit(SafetyTrace trace, void* ctx, SafetyEventKind kind, int process,
+                 int resource, int value, const int* vector, int length) {
+    SafetyEvent event = { kind, process, resource, value, vector, length };
+    trace(&event, ctx);
+}
+
+// Allocation row of process i, with row override_process replaced by override_row
+static inline const int* alloc_row(const int* alloc, int m, int i,
+                                   int override_process, const int* override_row) {
+    return i == override_process ? override_row : alloc + (size_t)i * m;
+}
+
+static bool check_state(const int* available, const int* claim, const int* alloc,
+                        int override_process, const int* override_row,
+                        SafetyResult* res, SafetyTrace trace, void* ctx) {
+    int n = res->processes;
+    int m = res->resources;
+    int* work = res->work;
+    bool* finish = res->finish;
+
+    if (trace) {
+        for (int i = 0; i < n; i++) {
+            const int* a = alloc_row(alloc, m, i, override_process, override_row);
+            for (int j = 0; j < m; j++) {
+                emit(trace, ctx, SAFETY_NEED, i, j, claim[(size_t)i * m + j] - a[j], NULL, m);
+            }
+        }
+    }
+
+    for (int j = 0; j < m; j++) {
+        work[j] = available[j];
+    }
+    for (int i = 0; i < n; i++) {
+        finish[i] = false;
+    }
+    if (trace) emit(trace, ctx, SAFETY_AVAIL, -1, -1, 0, work, m);
+
+    res->count = 0;
+    while (res->count < n) {
+        bool found = false;
+        for (int i = 0; i < n; i++) {
+            if (finish[i]) continue;
+
+            const int* c = claim + (size_t)i * m;
+            const int* a = alloc_row(alloc, m, i, override_process, override_row);
+            int j;
+            for (j = 0; j < m; j++) {
+                if (c[j] - a[j] > work[j]) break;
+            }
+            if (j < m) {
+                if (res->blocking) res->blocking[i] = j;
+                if (trace) emit(trace, ctx, SAFETY_BLOCKED, i, j, c[j] - a[j], NULL, 0);
+                continue;
+            }
+
+            if (trace) emit(trace, ctx, SAFETY_RELEASE, i, -1, 0, a, m);
+            for (j = 0; j < m; j++) {
+                work[j] += a[j];
+            }
+            if (trace) emit(trace, ctx, SAFETY_WORK, i, -1, 0, work, m);
+
+            if (res->blocking) res->blocking[i] = -1;
+            res->sequence[res->count++] = i;
+            finish[i] = true;
+            found = true;
+        }
+        if (!found) {
+            if (trace) emit(trace, ctx, SAFETY_UNSAFE, -1, -1, 0, res->sequence, res->count);
+            res->safe = false;
+            return false;
+        }
+    }
+
+    if (trace) emit(trace, ctx, SAFETY_SAFE, -1, -1, 0, res->sequence, res->count);
+    res->safe = true;
+    return true;
+}
+
+bool safety_check(const int* available, const int* claim, const int* alloc,
+                  SafetyResult* res, SafetyTrace trace, void* ctx) {
+    return check_state(available, claim, alloc, -1, NULL, res, trace, ctx);
+}
+
+// Shared, read-only base state plus a work counter for the batch workers
+typedef struct {
+    int processes;
+    int resources;
+    const int* available;
+    const int* claim;
+    const int* alloc;
+    const GrantRequest* candidates;
+    int count;
+    GrantVerdict* verdicts;
+    atomic_int next;
+} GrantBatch;
+
+static GrantVerdict evaluate_one(const GrantBatch* b, const GrantRequest* g,
+                                 int* avail_delta, int* row_delta, SafetyResult* res) {
+    int m = b->resources;
+    int p = g->process;
+    if (p < 0 || p >= b->processes) return GRANT_EXCEEDS_CLAIM;
+
+    const int* c = b->claim + (size_t)p * m;
+    const int* a = b->alloc + (size_t)p * m;
+
+    // Copy-on-write: only available and the requesting row are materialised
+    for (int j = 0; j < m; j++) {
+        if (g->request[j] < 0 || a[j] + g->request[j] > c[j]) return GRANT_EXCEEDS_CLAIM;
+        if (g->request[j] > b->available[j]) return GRANT_EXCEEDS_AVAILABLE;
+        avail_delta[j] = b->available[j] - g->request[j];
+        row_delta[j] = a[j] + g->request[j];
+    }
+
+    return check_state(avail_delta, b->claim, b->alloc, p, row_delta, res, NULL, NULL)
+           ? GRANT_SAFE : GRANT_UNSAFE;
+}
+
+static void* grant_worker(void* arg) {
+    GrantBatch* b = arg;
+    SafetyResult res;
+    int* avail_delta = malloc(sizeof(int) * b->resources);
+    int* row_delta = malloc(sizeof(int) * b->resources);
+
+    if (!avail_delta || !row_delta ||
+        safety_result_init(&res, b->processes, b->resources, false) != 0) {
+        free(avail_delta);
+        free(row_delta);
+        return NULL; // the other workers pick up the candidates
+    }
+
+    int k;
+    while ((k = atomic_fetch_add(&b->next, 1)) < b->count) {
+        b->verdicts[k] = evaluate_one(b, &b->candidates[k], avail_delta, row_delta, &res);
+    }
+
+    safety_result_free(&res);
+    free(avail_delta);
+    free(row_delta);
+    return NULL;
+}
+
+int evaluate_grants(int processes, int resources, const int* available,
+                    const int* claim, const int* alloc,
+                    const GrantRequest* candidates, int count,
+                    GrantVerdict* verdicts, int threads) {
+    GrantBatch b = { processes, resources, available, claim, alloc,
+                     candidates, count, verdicts, 0 };
+
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > count) threads = count;
+    if (threads <= 1) {
+        grant_worker(&b);
+        return atomic_load(&b.next) < count ? -1 : 0;
+    }
+
+    pthread_t* workers = malloc(sizeof(pthread_t) * threads);
+    if (!workers) return -1;
+
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&workers[started], NULL, grant_worker, &b) != 0) break;
+    }
+    if (started == 0) grant_worker(&b); // fall back to the calling thread
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+
+    free(workers);
+    return atomic_load(&b.next) < count ? -1 : 0;
+}
+
+static void print_vector(const int* v, int length) {
+    for (int j = 0; j < length; j++) {
+        printf("%d ", v[j]);
+    }
+}
+
+void safety_print_trace(const SafetyEvent* e, void* ctx) {
+    (void)ctx;
+
+    switch (e->kind) {
+    case SAFETY_NEED:
+        if (e->process == 0 && e->resource == 0) printf("The request matrix\n");
+        printf("\t%d", e->value);
+        if (e->resource == e->length - 1) printf("\n");
+        break;
+    case SAFETY_AVAIL:
+        printf("current avail. resource\n");
+        print_vector(e->vector, e->length);
+        printf("\n");
+        break;
+    case SAFETY_BLOCKED:
+        printf("Process %d failed: resource %d < request %d\n", e->process, e->resource, e->value);
+        break;
+    case SAFETY_RELEASE:
+        printf("Process %d can run to complete\n", e->process);
+        print_vector(e->vector, e->length);
+        printf(" released\n");
+        break;
+    case SAFETY_WORK:
+        printf("current avail. resources changed as\n");
+        print_vector(e->vector, e->length);
+        printf("\n");
+        break;
+    case SAFETY_UNSAFE:
+        printf("System is not in safe state\n");
+        break;
+    case SAFETY_SAFE:
+        printf("System is in safe state. Safe path is: ");
+        print_vector(e->vector, e->length);
+        printf("\n");
+        break;
+    }
+}
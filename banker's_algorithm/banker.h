@@ -0,0 +1,84 @@
+/*
+ * File: banker.h
+ * Banker's algorithm safety check, separated from its reporting.
+ *
+ * All matrices are row-major with one row per process:
+ *   claim[i * m + j]  maximum claim of process i on resource j
+ *   alloc[i * m + j]  currently allocated to process i of resource j
+ * The check itself never prints; pass a SafetyTrace to observe each step
+ * (safety_print_trace reproduces the classic verbose output) or NULL to
+ * run it quietly.
+ */
+
+#ifndef BANKER_H
+#define BANKER_H
+
+#include <stdbool.h>
+
+typedef enum {
+    SAFETY_NEED,     // need of (process, resource) is value, length = resources
+    SAFETY_AVAIL,    // initial work vector
+    SAFETY_BLOCKED,  // process blocked on resource, value = its need
+    SAFETY_RELEASE,  // process can finish, vector = its allocation
+    SAFETY_WORK,     // work vector after a release
+    SAFETY_UNSAFE,   // no further process can finish
+    SAFETY_SAFE      // vector = safe sequence
+} SafetyEventKind;
+
+typedef struct {
+    SafetyEventKind kind;
+    int process;
+    int resource;
+    int value;
+    const int* vector;
+    int length;
+} SafetyEvent;
+
+typedef void (*SafetyTrace)(const SafetyEvent* event, void* ctx);
+
+// Result of one check; buffers are owned and reused across calls
+typedef struct {
+    int processes;
+    int resources;
+    bool safe;
+    int count;        // processes placed in sequence
+    int* sequence;    // safe sequence (prefix of length count if unsafe)
+    int* blocking;    // first blocking resource per process, -1 if finished (optional)
+    int* work;        // scratch: available vector during the check
+    bool* finish;     // scratch: finished flags
+} SafetyResult;
+
+// Returns 0 on success, -1 if allocation fails
+int safety_result_init(SafetyResult* res, int processes, int resources, bool track_blocking);
+void safety_result_free(SafetyResult* res);
+
+// Core safety check; res must have been initialised with matching dimensions
+bool safety_check(const int* available, const int* claim, const int* alloc,
+                  SafetyResult* res, SafetyTrace trace, void* ctx);
+
+// A candidate grant: process asks for request[resources] more units
+typedef struct {
+    int process;
+    const int* request;
+} GrantRequest;
+
+typedef enum {
+    GRANT_SAFE,               // granting leaves the system in a safe state
+    GRANT_UNSAFE,             // granting would leave the system unsafe
+    GRANT_EXCEEDS_CLAIM,      // request goes beyond the process's maximum claim
+    GRANT_EXCEEDS_AVAILABLE   // not enough free units to grant right now
+} GrantVerdict;
+
+// What-if evaluation of count independent candidates against one shared,
+// immutable base state. Each candidate only copies available and its own
+// allocation row. threads <= 0 uses every online core.
+// Returns 0 on success, -1 if a worker could not allocate its scratch.
+int evaluate_grants(int processes, int resources, const int* available,
+                    const int* claim, const int* alloc,
+                    const GrantRequest* candidates, int count,
+                    GrantVerdict* verdicts, int threads);
+
+// Trace callback printing every step to stdout
+void safety_print_trace(const SafetyEvent* event, void* ctx);
+
+#endif
@@ -1,85 +1,243 @@
 //the current state lead to a deadlock and banker's lagorithms detects the deadlock and prevents it from happening by changing the state to unsafe (denying the request by the processes because there are not enough reouserces for all processes to finish)
+//build: gcc -pthread bankerAlgorithim.c banker.c banker_image.c -o banker
+//run with -q for quiet mode: only the verdict, safe sequence and blocking resources are printed
+//run with -w to evaluate a batch of candidate requests against a safe state in parallel
+//run with -i state.csv state.bkr to convert a CSV state into a binary image
+//run with -l state.bkr to map an image, replay its delta log and check it
+//run with -g state.bkr <process> <units...> to grant a request only if the state stays safe
+//(negative units release resources, which is always safe)
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
+#include "banker.h"
+#include "banker_image.h"
 #define P 5
 #define R 3
+#ifndef CHECKPOINT_EVERY
+#define CHECKPOINT_EVERY 1024 //delta log records between checkpoints
+#endif
 
-void calculateRequest(int request[P][R], int claim[P][R], int alloc[P][R]) {
-    printf("The request matrix\n");
-    for (int i = 0; i < P; i++) {
-        for (int j = 0; j < R; j++) {
-            request[i][j] = claim[i][j] - alloc[i][j];
-            printf("\t%d", request[i][j]);
+bool safe(int processes[P], int available[R], int claim[P][R], int alloc[P][R], bool quiet) {
+    SafetyResult res;
+    if (safety_result_init(&res, P, R, true) != 0) {
+        printf("Out of memory\n");
+        return false;
+    }
+
+    bool ok = safety_check(available, &claim[0][0], &alloc[0][0], &res,
+                           quiet ? NULL : safety_print_trace, NULL);
+
+    if (quiet) {
+        printf("%s", ok ? "SAFE" : "UNSAFE");
+        printf(" sequence:");
+        for (int i = 0; i < res.count; i++) {
+            printf(" %d", processes[res.sequence[i]]);
+        }
+        if (!ok) {
+            printf(" blocked:");
+            for (int i = 0; i < P; i++) {
+                if (!res.finish[i]) printf(" P%d(r%d)", processes[i], res.blocking[i]);
+            }
         }
         printf("\n");
     }
+
+    safety_result_free(&res);
+    return ok;
 }
 
-bool safe(int processes[P], int available[R], int claim[P][R], int alloc[P][R]) {
-    int request[P][R];
-    calculateRequest(request, claim, alloc);
-    bool finish[P] = {0};
-    int safeSeq[P];
-    int currentavail[R];
-    
-    for (int i = 0; i < R; i++) {
-        currentavail[i] = available[i];
-    }
-    
-    printf("current avail. resource\n");
-    for (int i = 0; i < R; i++) {
-        printf("%d ", currentavail[i]);
-    }
-    printf("\n");
-    
-    int count = 0;
-    while (count < P) {
-        bool found = false;
-        for (int i = 0; i < P; i++) {
-            if (finish[i] == 0) {
-                int j;
-                for (j = 0; j < R; j++) {
-                    if (request[i][j] > currentavail[j]) {
-                        printf("Process %d failed: resource %d < request %d\n", i, j, request[i][j]);
-                        break;
-                    }
-                }
-                if (j == R) {
-                    printf("Process %d can run to complete\n", i);
-                    for (j = 0; j < R; j++) {
-                        printf("%d ", alloc[i][j]);
-                    }
-                    printf(" released\n");
-                    for (int k = 0; k < R; k++) {
-                        currentavail[k] += alloc[i][k];
-                    }
-                    printf("current avail. resources changed as\n");
-                    for (int j = 0; j < R; j++) {
-                        printf("%d ", currentavail[j]);
-                    }
-                    printf("\n");
-                    safeSeq[count++] = i;
-                    finish[i] = 1;
-                    found = true;
-                }
-            }
-        }
-        if (found == false) {
-            printf("System is not in safe state\n");
-            return false;
+//what-if: which of several pending requests can be granted from one state
+void what_if() {
+    int available[R] = {3, 3, 2};
+    int claim[P][R] = {
+        {7, 5, 3},
+        {3, 2, 2},
+        {9, 0, 2},
+        {2, 2, 2},
+        {4, 3, 3}
+    };
+    int alloc[P][R] = {
+    {0, 1, 0},
+    {2, 0, 0},
+    {3, 0, 2},
+    {2, 1, 1},
+    {0, 0, 2}
+    };
+    int requests[][R] = {
+        {1, 0, 2},
+        {0, 2, 0},
+        {3, 3, 0},
+        {0, 1, 1},
+        {8, 0, 0},
+        {4, 0, 0}
+    };
+    int owners[] = {1, 0, 4, 3, 0, 2};
+    int k = sizeof(owners) / sizeof(owners[0]);
+    const char* names[] = {"granted (safe)", "denied (unsafe)", "denied (exceeds claim)", "must wait (not available)"};
+
+    GrantRequest candidates[sizeof(owners) / sizeof(owners[0])];
+    GrantVerdict verdicts[sizeof(owners) / sizeof(owners[0])];
+    for (int i = 0; i < k; i++) {
+        candidates[i].process = owners[i];
+        candidates[i].request = requests[i];
+    }
+
+    if (evaluate_grants(P, R, available, &claim[0][0], &alloc[0][0], candidates, k, verdicts, 0) != 0) {
+        printf("Out of memory\n");
+        return;
+    }
+    printf("What-if evaluation against available %d %d %d\n", available[0], available[1], available[2]);
+    for (int i = 0; i < k; i++) {
+        printf("Process %d requests %d %d %d: %s\n", owners[i],
+               requests[i][0], requests[i][1], requests[i][2], names[verdicts[i]]);
+    }
+}
+
+//map the image and bring it up to date with its delta log
+int open_state(const char* path, BankerImage* img) {
+    char log_path[4096];
+    banker_log_path(path, log_path, sizeof(log_path));
+
+    if (banker_image_map(path, img) != 0) {
+        printf("Cannot map state image %s\n", path);
+        return -1;
+    }
+    long discarded;
+    long replayed = banker_log_replay(log_path, img, &discarded);
+    if (replayed < 0) {
+        printf("Cannot replay delta log %s\n", log_path);
+        banker_image_unmap(img);
+        return -1;
+    }
+    printf("Loaded %d processes x %d resources (%ld log records replayed)\n",
+           img->processes, img->resources, replayed);
+    if (discarded > 0) {
+        printf("Discarded %ld log records after the last valid one (corrupt or from an earlier image)\n",
+               discarded);
+    }
+    return 0;
+}
+
+int load_state(const char* path) {
+    BankerImage img;
+    SafetyResult res;
+    if (open_state(path, &img) != 0) return 1;
+    if (safety_result_init(&res, img.processes, img.resources, false) != 0) {
+        printf("Out of memory\n");
+        banker_image_unmap(&img);
+        return 1;
+    }
+
+    bool ok = safety_check(img.available, img.claim, img.alloc, &res, NULL, NULL);
+    printf("System is %sin safe state (%d of %d processes can finish)\n",
+           ok ? "" : "not ", res.count, img.processes);
+
+    safety_result_free(&res);
+    banker_image_unmap(&img);
+    return ok ? 0 : 2;
+}
+
+int grant_state(const char* path, int process, char** units, int nunits) {
+    BankerImage img;
+    BankerLog log;
+    char log_path[4096];
+    if (open_state(path, &img) != 0) return 1;
+    if (nunits != img.resources) {
+        printf("Expected %d resource counts, got %d\n", img.resources, nunits);
+        banker_image_unmap(&img);
+        return 1;
+    }
+
+    int* request = malloc(sizeof(int) * img.resources);
+    if (!request) {
+        banker_image_unmap(&img);
+        return 1;
+    }
+    for (int j = 0; j < img.resources; j++) {
+        request[j] = atoi(units[j]);
+    }
+
+    const char* names[] = {"granted (safe)", "denied (unsafe)", "denied (exceeds claim)", "must wait (not available)"};
+    GrantRequest g = { process, request };
+    GrantVerdict verdict;
+    int rc = 1;
+    bool release = false;
+    for (int j = 0; j < img.resources; j++) {
+        if (request[j] < 0) release = true;
+    }
+    if (release) {
+        //releasing never makes a safe state unsafe, only check it is held
+        bool held = process >= 0 && process < img.processes;
+        for (int j = 0; held && j < img.resources; j++) {
+            if (request[j] > 0 || img.alloc[process * img.resources + j] + request[j] < 0) held = false;
         }
+        printf("Process %d: %s\n", process, held ? "released" : "denied (not held)");
+        verdict = held ? GRANT_SAFE : GRANT_EXCEEDS_CLAIM;
+    } else if (evaluate_grants(img.processes, img.resources, img.available, img.claim, img.alloc,
+                        &g, 1, &verdict, 1) != 0) {
+        printf("Out of memory\n");
+        goto out;
+    } else {
+        printf("Process %d: %s\n", process, names[verdict]);
     }
-    
-    printf("System is in safe state. Safe path is: ");
-    for (int i = 0; i < P; i++) {
-        printf("%d ", safeSeq[i]);
+    if (verdict != GRANT_SAFE) {
+        rc = 2;
+        goto out;
+    }
+
+    banker_log_path(path, log_path, sizeof(log_path));
+    if (banker_log_open(&log, log_path, &img) != 0 ||
+        banker_log_append(&log, process, request) != 0) {
+        printf("Cannot append to delta log %s\n", log_path);
+        goto out;
     }
-    printf("\n");
-    return true;
+    banker_image_apply(&img, process, request);
+    if (log.records >= CHECKPOINT_EVERY) {
+        if (banker_checkpoint(&img, path, &log) != 0) {
+            printf("Checkpoint failed, the delta log still holds every change\n");
+        } else {
+            printf("Checkpoint written to %s\n", path);
+        }
+    }
+    banker_log_close(&log);
+    rc = 0;
+
+out:
+    free(request);
+    banker_image_unmap(&img);
+    return rc;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc == 4 && strcmp(argv[1], "-i") == 0) {
+        FILE* in = fopen(argv[2], "r");
+        if (!in || banker_import_csv(in, argv[3]) != 0) {
+            printf("Cannot import %s into %s\n", argv[2], argv[3]);
+            if (in) fclose(in);
+            return 1;
+        }
+        fclose(in);
+        return load_state(argv[3]);
+    }
+    if (argc == 3 && strcmp(argv[1], "-l") == 0) {
+        return load_state(argv[2]);
+    }
+    if (argc >= 4 && strcmp(argv[1], "-g") == 0) {
+        return grant_state(argv[2], atoi(argv[3]), argv + 4, argc - 4);
+    }
+
+    bool quiet = false;
+    bool batch = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) quiet = true;
+        if (strcmp(argv[i], "-w") == 0) batch = true;
+    }
+    if (batch) {
+        what_if();
+        return 0;
+    }
     int processes[P] = {0, 1, 2, 3, 4};
     int available[R] = {0, 0, 1};
     int claim[P][R] = {
@@ -96,6 +254,6 @@ int main() {
     {2, 1, 1},
     {0, 0, 2}
     };
-    safe(processes, available, claim, alloc);
+    safe(processes, available, claim, alloc, quiet);
     return 0;
 }
@@ -0,0 +1,422 @@
+/*
+ * File: banker_image.c
+ * Binary banker's state: mmap loader, streaming CSV importer,
+ * append-only delta log and checkpointing.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "banker_image.h"
+
+_Static_assert(sizeof(int) == sizeof(int32_t), "image stores int as int32");
+_Static_assert(sizeof(BankerImageHeader) == BANKER_IMAGE_ALIGN, "header fills one aligned block");
+
+typedef struct {
+    uint32_t magic;
+    uint32_t checksum;   // FNV-1a over process and delta
+    uint64_t sequence;
+    int32_t process;
+    uint32_t epoch;      // epoch of the image the record was written against
+} BankerLogRecord;
+
+static uint64_t align_up(uint64_t x) {
+    return (x + BANKER_IMAGE_ALIGN - 1) & ~(uint64_t)(BANKER_IMAGE_ALIGN - 1);
+}
+
+static void layout(BankerImageHeader* h, int processes, int resources,
+                   uint64_t log_sequence, uint32_t epoch) {
+    uint64_t row_bytes = (uint64_t)resources * sizeof(int32_t);
+    uint64_t matrix_bytes = (uint64_t)processes * row_bytes;
+
+    memset(h, 0, sizeof(*h));
+    h->magic = BANKER_IMAGE_MAGIC;
+    h->version = BANKER_IMAGE_VERSION;
+    h->processes = processes;
+    h->resources = resources;
+    h->available_offset = sizeof(BankerImageHeader);
+    h->claim_offset = align_up(h->available_offset + row_bytes);
+    h->alloc_offset = align_up(h->claim_offset + matrix_bytes);
+    h->file_size = align_up(h->alloc_offset + matrix_bytes);
+    h->log_sequence = log_sequence;
+    h->epoch = epoch;
+}
+
+uint32_t banker_new_epoch(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t x = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec + ((uint64_t)getpid() << 32);
+    // splitmix64 finalizer; 0 is the epoch of images from before epochs
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return (uint32_t)x ? (uint32_t)x : 1;
+}
+
+static int write_all(int fd, const void* buf, size_t len) {
+    const char* p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Pads the file with zeros up to offset
+static int pad_to(int fd, uint64_t* pos, uint64_t offset) {
+    static const char zeros[BANKER_IMAGE_ALIGN];
+    if (write_all(fd, zeros, offset - *pos) != 0) return -1;
+    *pos = offset;
+    return 0;
+}
+
+static int write_section(int fd, uint64_t* pos, uint64_t offset, const int* data, uint64_t count) {
+    if (pad_to(fd, pos, offset) != 0) return -1;
+    if (write_all(fd, data, count * sizeof(int32_t)) != 0) return -1;
+    *pos += count * sizeof(int32_t);
+    return 0;
+}
+
+// Temp file next to path, renamed over it once complete
+static int open_temp(const char* path, char* tmp, size_t size) {
+    snprintf(tmp, size, "%s.tmp", path);
+    return open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+// Make a rename in path's directory durable
+static int sync_parent_dir(const char* path) {
+    char dir[4096];
+    const char* slash = strrchr(path, '/');
+
+    if (!slash) {
+        snprintf(dir, sizeof(dir), ".");
+    } else {
+        snprintf(dir, sizeof(dir), "%.*s", slash == path ? 1 : (int)(slash - path), path);
+    }
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return -1;
+    int rc = fsync(fd);
+    close(fd);
+    return rc;
+}
+
+// Durable once this returns 0: the data, then the rename itself
+static int commit_temp(int fd, const char* tmp, const char* path) {
+    if (fsync(fd) != 0) {
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    close(fd);
+    if (rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return sync_parent_dir(path);
+}
+
+int banker_image_write(const char* path, int processes, int resources,
+                       const int* available, const int* claim, const int* alloc,
+                       uint64_t log_sequence, uint32_t epoch) {
+    BankerImageHeader h;
+    char tmp[4096];
+    uint64_t pos = sizeof(h);
+    uint64_t cells = (uint64_t)processes * resources;
+
+    layout(&h, processes, resources, log_sequence, epoch);
+    int fd = open_temp(path, tmp, sizeof(tmp));
+    if (fd < 0) return -1;
+
+    if (write_all(fd, &h, sizeof(h)) != 0 ||
+        write_section(fd, &pos, h.available_offset, available, resources) != 0 ||
+        write_section(fd, &pos, h.claim_offset, claim, cells) != 0 ||
+        write_section(fd, &pos, h.alloc_offset, alloc, cells) != 0 ||
+        pad_to(fd, &pos, h.file_size) != 0) {
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    return commit_temp(fd, tmp, path);
+}
+
+int banker_image_map(const char* path, BankerImage* img) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BankerImageHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    void* base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return -1;
+
+    const BankerImageHeader* h = base;
+    BankerImageHeader expect;
+    if (h->magic != BANKER_IMAGE_MAGIC || h->version != BANKER_IMAGE_VERSION ||
+        h->processes < 0 || h->resources < 0) {
+        munmap(base, st.st_size);
+        return -1;
+    }
+    layout(&expect, h->processes, h->resources, h->log_sequence, h->epoch);
+    if (expect.file_size != (uint64_t)st.st_size || expect.available_offset != h->available_offset ||
+        expect.claim_offset != h->claim_offset || expect.alloc_offset != h->alloc_offset) {
+        munmap(base, st.st_size);
+        return -1;
+    }
+
+    img->base = base;
+    img->size = st.st_size;
+    img->processes = h->processes;
+    img->resources = h->resources;
+    img->available = (int*)((char*)base + h->available_offset);
+    img->claim = (int*)((char*)base + h->claim_offset);
+    img->alloc = (int*)((char*)base + h->alloc_offset);
+    img->log_sequence = h->log_sequence;
+    img->epoch = h->epoch;
+    return 0;
+}
+
+void banker_image_unmap(BankerImage* img) {
+    if (img->base) munmap(img->base, img->size);
+    img->base = NULL;
+}
+
+// Parses exactly count comma/space separated integers from line
+static int parse_row(const char* line, int* row, int count) {
+    const char* p = line;
+    for (int j = 0; j < count; j++) {
+        char* end;
+        while (*p == ',' || *p == ' ' || *p == '\t') p++;
+        errno = 0;
+        long v = strtol(p, &end, 10);
+        if (end == p || errno != 0 || v < INT32_MIN || v > INT32_MAX) return -1;
+        row[j] = (int)v;
+        p = end;
+    }
+    while (*p == ',' || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return *p == '\0' ? 0 : -1;
+}
+
+// Next non-blank, non-comment line; NULL at end of input
+static char* next_line(FILE* in, char** line, size_t* cap) {
+    while (getline(line, cap, in) >= 0) {
+        char* p = *line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p != '#' && *p != '\n' && *p != '\r' && *p != '\0') return p;
+    }
+    return NULL;
+}
+
+int banker_import_csv(FILE* in, const char* path) {
+    char* line = NULL;
+    size_t cap = 0;
+    int dims[2];
+    int* row = NULL;
+    int fd = -1;
+    char tmp[4096];
+    BankerImageHeader h;
+    uint64_t pos = sizeof(h);
+
+    char* p = next_line(in, &line, &cap);
+    if (!p || parse_row(p, dims, 2) != 0 || dims[0] <= 0 || dims[1] <= 0) goto fail;
+
+    layout(&h, dims[0], dims[1], 0, banker_new_epoch());
+    row = malloc(sizeof(int) * dims[1]);
+    fd = open_temp(path, tmp, sizeof(tmp));
+    if (!row || fd < 0 || write_all(fd, &h, sizeof(h)) != 0) goto fail;
+
+    // available, then every claim row, then every alloc row: each streamed
+    // straight to its place in the image
+    uint64_t offsets[3] = { h.available_offset, h.claim_offset, h.alloc_offset };
+    int rows[3] = { 1, dims[0], dims[0] };
+    for (int s = 0; s < 3; s++) {
+        if (pad_to(fd, &pos, offsets[s]) != 0) goto fail;
+        for (int i = 0; i < rows[s]; i++) {
+            p = next_line(in, &line, &cap);
+            if (!p || parse_row(p, row, dims[1]) != 0) goto fail;
+            if (write_all(fd, row, sizeof(int32_t) * dims[1]) != 0) goto fail;
+            pos += sizeof(int32_t) * dims[1];
+        }
+    }
+    if (pad_to(fd, &pos, h.file_size) != 0) goto fail;
+
+    free(line);
+    free(row);
+    if (commit_temp(fd, tmp, path) != 0) return -1;
+
+    // The new epoch already shuts out an old log; removing it keeps the
+    // next load from reporting its records as discarded
+    char log_path[4096];
+    banker_log_path(path, log_path, sizeof(log_path));
+    if (unlink(log_path) != 0 && errno != ENOENT) return -1;
+    return 0;
+
+fail:
+    if (fd >= 0) {
+        close(fd);
+        unlink(tmp);
+    }
+    free(line);
+    free(row);
+    return -1;
+}
+
+void banker_image_apply(BankerImage* img, int process, const int* delta) {
+    int* a = img->alloc + (size_t)process * img->resources;
+    for (int j = 0; j < img->resources; j++) {
+        a[j] += delta[j];
+        img->available[j] -= delta[j];
+    }
+}
+
+void banker_log_path(const char* image_path, char* out, size_t size) {
+    snprintf(out, size, "%s.log", image_path);
+}
+
+static uint32_t record_checksum(int process, const int* delta, int resources) {
+    uint32_t hash = 2166136261u;
+    const unsigned char* p = (const unsigned char*)&process;
+    for (size_t i = 0; i < sizeof(process); i++) hash = (hash ^ p[i]) * 16777619u;
+    p = (const unsigned char*)delta;
+    for (size_t i = 0; i < sizeof(int) * (size_t)resources; i++) hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+static size_t record_size(int resources) {
+    return sizeof(BankerLogRecord) + sizeof(int32_t) * (size_t)resources;
+}
+
+// Reads the record at offset into buf; true if it is whole, intact, of the
+// image's epoch and carries the expected sequence number
+static bool read_record(int fd, uint64_t offset, const BankerImage* img, uint64_t sequence,
+                        char* buf, BankerLogRecord* r) {
+    size_t size = record_size(img->resources);
+    if (pread(fd, buf, size, (off_t)offset) != (ssize_t)size) return false; // end or torn tail
+
+    memcpy(r, buf, sizeof(*r));
+    return r->magic == BANKER_LOG_MAGIC && r->epoch == img->epoch && r->sequence == sequence &&
+           r->process >= 0 && r->process < img->processes &&
+           r->checksum == record_checksum(r->process, (const int*)(buf + sizeof(*r)), img->resources);
+}
+
+// Walks the valid records from the start of the log, applying them to img
+// when apply is set. Returns the number of valid records and their length
+// in *valid_bytes, or -1.
+static long scan_log(int fd, BankerImage* img, bool apply, uint64_t* valid_bytes) {
+    // The log continues from the sequence the image file was written at
+    uint64_t sequence = ((const BankerImageHeader*)img->base)->log_sequence;
+    size_t size = record_size(img->resources);
+    char* buf = malloc(size);
+    BankerLogRecord r;
+    long count = 0;
+
+    if (!buf) return -1;
+    while (read_record(fd, (uint64_t)count * size, img, sequence, buf, &r)) {
+        if (apply) {
+            banker_image_apply(img, r.process, (const int*)(buf + sizeof(r)));
+            img->log_sequence = sequence + 1;
+        }
+        sequence++;
+        count++;
+    }
+    free(buf);
+    *valid_bytes = (uint64_t)count * size;
+    return count;
+}
+
+int banker_log_open(BankerLog* log, const char* path, BankerImage* img) {
+    struct stat st;
+    uint64_t valid;
+    log->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (log->fd < 0) return -1;
+
+    // Cut the log after its last valid record: a torn or corrupt record, or
+    // one left by an earlier image, must not sit in front of new appends
+    long records = scan_log(log->fd, img, false, &valid);
+    if (records < 0 || fstat(log->fd, &st) != 0 ||
+        ((uint64_t)st.st_size != valid && ftruncate(log->fd, (off_t)valid) != 0)) {
+        close(log->fd);
+        return -1;
+    }
+    log->records = (uint64_t)records;
+    log->resources = img->resources;
+    log->epoch = img->epoch;
+    log->next_sequence = img->log_sequence;
+    return 0;
+}
+
+int banker_log_append(BankerLog* log, int process, const int* delta) {
+    size_t size = record_size(log->resources);
+    char* buf = malloc(size);
+    if (!buf) return -1;
+
+    BankerLogRecord r = { BANKER_LOG_MAGIC, record_checksum(process, delta, log->resources),
+                          log->next_sequence, process, log->epoch };
+    memcpy(buf, &r, sizeof(r));
+    memcpy(buf + sizeof(r), delta, sizeof(int32_t) * log->resources);
+
+    // One write per record so an O_APPEND record is never interleaved, and
+    // on disk before the grant is reported
+    int rc = write_all(log->fd, buf, size);
+    free(buf);
+    if (rc != 0 || fdatasync(log->fd) != 0) return -1;
+
+    log->next_sequence++;
+    log->records++;
+    return 0;
+}
+
+void banker_log_close(BankerLog* log) {
+    if (log->fd >= 0) close(log->fd);
+    log->fd = -1;
+}
+
+long banker_log_replay(const char* path, BankerImage* img, long* discarded) {
+    struct stat st;
+    uint64_t valid;
+
+    *discarded = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return errno == ENOENT ? 0 : -1;
+
+    long applied = scan_log(fd, img, true, &valid);
+    if (applied >= 0 && fstat(fd, &st) == 0) {
+        *discarded = (long)(((uint64_t)st.st_size - valid) / record_size(img->resources));
+    }
+    close(fd);
+    return applied;
+}
+
+int banker_checkpoint(BankerImage* img, const char* image_path, BankerLog* log) {
+    uint32_t epoch = banker_new_epoch();
+    if (banker_image_write(image_path, img->processes, img->resources,
+                           img->available, img->claim, img->alloc, log->next_sequence, epoch) != 0) {
+        return -1;
+    }
+    // The new image is durable, rename included, so the log may go. A
+    // crash before the truncate only leaves records of the old epoch,
+    // which the new image discards.
+    if (ftruncate(log->fd, 0) != 0) return -1;
+    img->log_sequence = log->next_sequence;
+    img->epoch = epoch;
+    ((BankerImageHeader*)img->base)->log_sequence = log->next_sequence;
+    ((BankerImageHeader*)img->base)->epoch = epoch;
+    log->epoch = epoch;
+    log->records = 0;
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * File: banker_image.h
+ * On-disk binary format for banker's state, usable in place after mmap.
+ *
+ * Layout (native byte order, every section aligned to BANKER_IMAGE_ALIGN):
+ *   BankerImageHeader
+ *   available  int32[resources]
+ *   claim      int32[processes * resources]   row-major
+ *   alloc      int32[processes * resources]   row-major
+ *
+ * Changes to the live state are appended to a delta log next to the image
+ * (<image>.log). A checkpoint rewrites the image atomically and truncates
+ * the log, so a restart is one mmap plus a replay of the log tail.
+ *
+ * Every image written gets a fresh epoch, stamped into each log record
+ * appended against it. A record only counts if it carries the image's
+ * epoch, is intact and is next in sequence; replay stops at the first
+ * one that is not, and opening the log for append truncates it there, so
+ * a stale log from an earlier image or a damaged record is never applied
+ * and never buries later appends.
+ */
+
+#ifndef BANKER_IMAGE_H
+#define BANKER_IMAGE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define BANKER_IMAGE_MAGIC   0x524b4e42u  // "BNKR"
+#define BANKER_LOG_MAGIC     0x474c4b42u  // "BKLG"
+#define BANKER_IMAGE_VERSION 1
+#define BANKER_IMAGE_ALIGN   64
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t processes;
+    int32_t resources;
+    uint64_t available_offset;
+    uint64_t claim_offset;
+    uint64_t alloc_offset;
+    uint64_t file_size;
+    uint64_t log_sequence;   // delta records already folded into this image
+    uint32_t epoch;          // log records must carry the same epoch
+    uint8_t reserved[4];
+} BankerImageHeader;
+
+// A mapped image; the matrices point straight into the mapping
+typedef struct {
+    void* base;
+    size_t size;
+    int processes;
+    int resources;
+    int* available;
+    int* claim;
+    int* alloc;
+    uint64_t log_sequence;
+    uint32_t epoch;
+} BankerImage;
+
+// Append-only delta log: each record adds delta[] to one allocation row
+typedef struct {
+    int fd;
+    int resources;
+    uint32_t epoch;
+    uint64_t next_sequence;
+    uint64_t records;        // records written since the last checkpoint
+} BankerLog;
+
+// A new epoch for an image about to be written
+uint32_t banker_new_epoch(void);
+
+// Writes a complete image atomically (temp file + rename). Returns 0 or -1.
+int banker_image_write(const char* path, int processes, int resources,
+                       const int* available, const int* claim, const int* alloc,
+                       uint64_t log_sequence, uint32_t epoch);
+
+// Maps an image copy-on-write: the state can be updated in memory without
+// touching the file. Returns 0 or -1 (bad file, wrong magic/version/size).
+int banker_image_map(const char* path, BankerImage* img);
+void banker_image_unmap(BankerImage* img);
+
+// Converts a CSV state to an image line by line, never holding a matrix in
+// memory. Format: "processes,resources", then the available row, then
+// one claim row per process, then one alloc row per process. Blank lines
+// and lines starting with '#' are ignored. A log left by an earlier image
+// at the same path is removed. Returns 0 or -1.
+int banker_import_csv(FILE* in, const char* path);
+
+// Grants (positive) or releases (negative) delta[] for one process
+void banker_image_apply(BankerImage* img, int process, const int* delta);
+
+// Log path for an image: <image>.log
+void banker_log_path(const char* image_path, char* out, size_t size);
+
+// Opens the log of a freshly mapped and replayed image for appending,
+// truncating it after its last valid record. Returns 0 or -1.
+int banker_log_open(BankerLog* log, const char* path, BankerImage* img);
+// Appends one record and flushes it to disk (fdatasync) before returning
+int banker_log_append(BankerLog* log, int process, const int* delta);
+void banker_log_close(BankerLog* log);
+
+// Applies the valid records of the log to a freshly mapped image. Replay
+// ends at a torn tail (crash mid-append), a corrupt record or a record of
+// another epoch; *discarded counts the whole records from there on.
+// Returns records applied or -1.
+long banker_log_replay(const char* path, BankerImage* img, long* discarded);
+
+// Writes the live state as a new image and truncates the log
+int banker_checkpoint(BankerImage* img, const char* image_path, BankerLog* log);
+
+#endif
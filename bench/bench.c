@@ -0,0 +1,515 @@
+/*
+ * File: bench.c
+ * Micro-benchmarks for the repository's synchronization code, as JSON.
+ *
+ *   bounded_buffer        1 producer -> 1 consumer through a 5-slot pipeline queue
+ *   rw_reader_priority    4 readers + 1 writer, the readerPriority.c semaphore protocol
+ *   rw_pthread            same workload on pthread_rwlock_t (default policy)
+ *   rw_pthread_writer     same, writer-preferring pthread_rwlock_t
+ *   gate_assign_release   4 threads taking and releasing gates in airport_sync.c
+ *   banker_safety         safety_check on 64 processes x 16 resources
+ *   slab_cross_thread     4 threads allocate 64-byte records, a neighbour frees them
+ *   malloc_cross_thread   same workload on malloc/free
+ *
+ * Each benchmark runs --runs times and reports the median ns per operation
+ * and how much the resident set grew over its runs.
+ *
+ * Usage: bench [--runs N] [--filter substring] [--out results.json]
+ *              [--baseline baseline.json [--threshold pct]]
+ * With --baseline every result carries the baseline and its change, and the
+ * exit status is 1 if any benchmark is slower than the threshold (default 10%).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "../semaphores/pipeline.h"
+#include "../threads/reader_priority.h"
+#include "../banker's_algorithm/banker.h"
+#include "../airport-gate-synchronization/slab.h"
+#include "../airport-gate-synchronization/airport_sync.h"
+
+#define MAX_RUNS 32
+#define MAX_RESULTS 16
+
+typedef struct {
+    const char* name;
+    long ops;                    // Operations per run
+    double (*run)(long ops);     // Returns elapsed ns for ops operations
+} Benchmark;
+
+typedef struct {
+    const char* name;
+    long ops;
+    int runs;
+    double ns_per_op;
+    long rss_delta_kb;           // Resident set growth over warm-up and runs
+    double baseline_ns_per_op;   // < 0: not in the baseline
+} Result;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Bounded buffer
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    atomic_long next;
+    long total;
+} CountSource;
+
+static bool count_source(void* ctx, void** item) {
+    CountSource* cs = ctx;
+    long id = atomic_fetch_add_explicit(&cs->next, 1, memory_order_relaxed);
+    *item = (void*)(id + 1);
+    return id < cs->total;
+}
+
+static void drop_sink(void* ctx, void* item) {
+    (void)ctx;
+    (void)item;
+}
+
+static double bench_bounded_buffer(long ops) {
+    Pipeline p;
+    CountSource cs;
+
+    atomic_init(&cs.next, 0);
+    cs.total = ops;
+    pipeline_init(&p);
+    pipeline_source(&p, "produce", count_source, &cs, 1);
+    pipeline_sink(&p, "consume", drop_sink, NULL, 1, 5);
+
+    double t0 = now_ns();
+    if (pipeline_start(&p) != 0) {
+        fprintf(stderr, "bounded_buffer: cannot start the pipeline\n");
+        exit(1);
+    }
+    pipeline_wait(&p);
+    double elapsed = now_ns() - t0;
+
+    pipeline_destroy(&p);
+    return elapsed;
+}
+
+// ---------------------------------------------------------------------------
+// Reader/writer policies: RW_READERS readers and one writer share ops
+// ---------------------------------------------------------------------------
+
+#define RW_READERS 4
+#define RW_CELLS 16
+
+typedef enum { RW_READER_PRIORITY, RW_PTHREAD, RW_PTHREAD_WRITER } RwPolicy;
+
+typedef struct {
+    RwPolicy policy;
+    ReaderPriority rp;           // The lock readerPriority.c runs on
+    pthread_rwlock_t rwlock;
+    long cells[RW_CELLS];
+    long ops_per_thread;
+} RwState;
+
+typedef struct {
+    RwState* st;
+    bool writer;
+    long checksum;
+} RwWorker;
+
+static void* rw_worker(void* arg) {
+    RwWorker* w = arg;
+    RwState* st = w->st;
+
+    for (long i = 0; i < st->ops_per_thread; i++) {
+        if (st->policy == RW_READER_PRIORITY) {
+            if (w->writer) {
+                writer_enter(&st->rp);
+                st->cells[i % RW_CELLS]++;
+                writer_exit(&st->rp);
+            } else {
+                reader_enter(&st->rp);
+                for (int c = 0; c < RW_CELLS; c++) w->checksum += st->cells[c];
+                reader_exit(&st->rp);
+            }
+        } else if (w->writer) {
+            pthread_rwlock_wrlock(&st->rwlock);
+            st->cells[i % RW_CELLS]++;
+            pthread_rwlock_unlock(&st->rwlock);
+        } else {
+            pthread_rwlock_rdlock(&st->rwlock);
+            for (int c = 0; c < RW_CELLS; c++) w->checksum += st->cells[c];
+            pthread_rwlock_unlock(&st->rwlock);
+        }
+    }
+    return NULL;
+}
+
+static double bench_rw(RwPolicy policy, long ops) {
+    RwState st;
+    RwWorker workers[RW_READERS + 1];
+    pthread_t threads[RW_READERS + 1];
+    pthread_rwlockattr_t attr;
+
+    memset(&st, 0, sizeof(st));
+    st.policy = policy;
+    st.ops_per_thread = ops / (RW_READERS + 1);
+    if (reader_priority_init(&st.rp) != 0) {
+        fprintf(stderr, "rw: cannot create the reader/writer semaphores\n");
+        exit(1);
+    }
+    pthread_rwlockattr_init(&attr);
+    if (policy == RW_PTHREAD_WRITER) {
+        pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    }
+    pthread_rwlock_init(&st.rwlock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+
+    double t0 = now_ns();
+    for (int i = 0; i <= RW_READERS; i++) {
+        workers[i].st = &st;
+        workers[i].writer = i == RW_READERS;
+        workers[i].checksum = 0;
+        pthread_create(&threads[i], NULL, rw_worker, &workers[i]);
+    }
+    for (int i = 0; i <= RW_READERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now_ns() - t0;
+
+    reader_priority_destroy(&st.rp);
+    pthread_rwlock_destroy(&st.rwlock);
+    return elapsed;
+}
+
+static double bench_rw_reader_priority(long ops) { return bench_rw(RW_READER_PRIORITY, ops); }
+static double bench_rw_pthread(long ops) { return bench_rw(RW_PTHREAD, ops); }
+static double bench_rw_pthread_writer(long ops) { return bench_rw(RW_PTHREAD_WRITER, ops); }
+
+// ---------------------------------------------------------------------------
+// Gate assignment and release (no time thread: every flight arrives at
+// 01:00, after the previous occupant's cleaning)
+// ---------------------------------------------------------------------------
+
+#define GATE_THREADS 4
+
+static void* gate_worker(void* arg) {
+    long ops = *(long*)arg;
+
+    for (long i = 0; i < ops; i++) {
+        int flight_id = (int)(i % 1000) + 1;
+        int gate = take_gate(DOMESTIC, flight_id, false, 1, 1);
+        if (gate != -1) release_gate_safe(gate, flight_id);
+    }
+    return NULL;
+}
+
+static double bench_gate_assign_release(long ops) {
+    static bool initialized = false;
+    pthread_t threads[GATE_THREADS];
+    long per_thread = ops / GATE_THREADS;
+
+    if (!initialized) {
+        verbose_log = false;
+        init_airport_sync();
+        initialized = true;
+    }
+
+    double t0 = now_ns();
+    for (int i = 0; i < GATE_THREADS; i++) {
+        pthread_create(&threads[i], NULL, gate_worker, &per_thread);
+    }
+    for (int i = 0; i < GATE_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return now_ns() - t0;
+}
+
+// ---------------------------------------------------------------------------
+// Banker safety check
+// ---------------------------------------------------------------------------
+
+#define BANKER_PROCESSES 64
+#define BANKER_RESOURCES 16
+
+static double bench_banker_safety(long ops) {
+    int n = BANKER_PROCESSES, m = BANKER_RESOURCES;
+    int claim[BANKER_PROCESSES * BANKER_RESOURCES];
+    int alloc[BANKER_PROCESSES * BANKER_RESOURCES];
+    int available[BANKER_RESOURCES];
+    SafetyResult res;
+    unsigned seed = 12345;
+
+    // Fixed, safe but not trivially ordered state
+    for (int j = 0; j < m; j++) available[j] = 0;
+    for (int i = 0; i < n * m; i++) {
+        claim[i] = 1 + rand_r(&seed) % 10;
+        alloc[i] = rand_r(&seed) % (claim[i] + 1);
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < m; j++) {
+            int need = claim[i * m + j] - alloc[i * m + j];
+            if (need > available[j]) available[j] = need;
+        }
+    }
+    for (int j = 0; j < m; j++) available[j] /= 2;
+    if (safety_result_init(&res, n, m, false) != 0) {
+        fprintf(stderr, "banker_safety: cannot allocate the safety check state\n");
+        exit(1);
+    }
+
+    volatile int safe_count = 0;
+    double t0 = now_ns();
+    for (long k = 0; k < ops; k++) {
+        safe_count += safety_check(available, claim, alloc, &res, NULL, NULL);
+    }
+    double elapsed = now_ns() - t0;
+
+    safety_result_free(&res);
+    return elapsed;
+}
+
+// ---------------------------------------------------------------------------
+// Record allocation: every record is freed by a different thread than the
+// one that allocated it, as with flight parameters
+// ---------------------------------------------------------------------------
+
+#define ALLOC_THREADS 4
+#define ALLOC_BATCH 1024
+#define RECORD_SIZE 64
+
+typedef struct {
+    bool use_slab;
+    SlabCache cache;
+    long rounds;
+    pthread_barrier_t barrier;
+    void* batches[ALLOC_THREADS][ALLOC_BATCH];
+} AllocState;
+
+typedef struct {
+    AllocState* st;
+    int index;
+} AllocWorker;
+
+static void* alloc_worker(void* arg) {
+    AllocWorker* w = arg;
+    AllocState* st = w->st;
+    void** mine = st->batches[w->index];
+    void** neighbour = st->batches[(w->index + 1) % ALLOC_THREADS];
+
+    for (long r = 0; r < st->rounds; r++) {
+        for (int i = 0; i < ALLOC_BATCH; i++) {
+            mine[i] = st->use_slab ? slab_alloc(&st->cache) : malloc(RECORD_SIZE);
+            *(long*)mine[i] = r;
+        }
+        pthread_barrier_wait(&st->barrier);
+        for (int i = 0; i < ALLOC_BATCH; i++) {
+            if (st->use_slab) {
+                slab_free(neighbour[i]);
+            } else {
+                free(neighbour[i]);
+            }
+        }
+        pthread_barrier_wait(&st->barrier);
+    }
+    return NULL;
+}
+
+static double bench_alloc(bool use_slab, long ops) {
+    static AllocState st;
+    static bool cache_ready = false;
+    AllocWorker workers[ALLOC_THREADS];
+    pthread_t threads[ALLOC_THREADS];
+
+    st.use_slab = use_slab;
+    st.rounds = ops / (ALLOC_THREADS * ALLOC_BATCH);
+    if (use_slab && !cache_ready) {
+        slab_cache_init(&st.cache, "record", RECORD_SIZE);
+        cache_ready = true;
+    }
+    pthread_barrier_init(&st.barrier, NULL, ALLOC_THREADS);
+
+    double t0 = now_ns();
+    for (int i = 0; i < ALLOC_THREADS; i++) {
+        workers[i].st = &st;
+        workers[i].index = i;
+        pthread_create(&threads[i], NULL, alloc_worker, &workers[i]);
+    }
+    for (int i = 0; i < ALLOC_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now_ns() - t0;
+
+    pthread_barrier_destroy(&st.barrier);
+    // Between runs: drop everything at once, keep the chunks
+    if (use_slab) slab_reset(&st.cache);
+    return elapsed;
+}
+
+static double bench_slab_cross_thread(long ops) { return bench_alloc(true, ops); }
+static double bench_malloc_cross_thread(long ops) { return bench_alloc(false, ops); }
+
+static const Benchmark benchmarks[] = {
+    { "bounded_buffer",      200000, bench_bounded_buffer },
+    { "rw_reader_priority",  500000, bench_rw_reader_priority },
+    { "rw_pthread",          500000, bench_rw_pthread },
+    { "rw_pthread_writer",   500000, bench_rw_pthread_writer },
+    { "gate_assign_release", 200000, bench_gate_assign_release },
+    { "banker_safety",        20000, bench_banker_safety },
+    { "slab_cross_thread",  2097152, bench_slab_cross_thread },
+    { "malloc_cross_thread", 2097152, bench_malloc_cross_thread },
+};
+
+// ---------------------------------------------------------------------------
+// Baseline and output
+// ---------------------------------------------------------------------------
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// ns_per_op of name in a file written by this program, or -1
+static double baseline_lookup(const char* json, const char* name) {
+    char key[128];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    const char* at = strstr(json, key);
+    if (!at) return -1;
+    const char* field = strstr(at, "\"ns_per_op\": ");
+    const char* end = strchr(at, '}');
+    if (!field || (end && field > end)) return -1;
+    return strtod(field + strlen("\"ns_per_op\": "), NULL);
+}
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* data = malloc(size + 1);
+    if (data && fread(data, 1, size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    if (data) data[size] = '\0';
+    fclose(f);
+    return data;
+}
+
+static void write_json(FILE* f, const Result* results, int count, bool compare, double threshold) {
+    fprintf(f, "{\n  \"schema\": 1,\n");
+    if (compare) fprintf(f, "  \"threshold_pct\": %.1f,\n", threshold);
+    fprintf(f, "  \"benchmarks\": [\n");
+    for (int i = 0; i < count; i++) {
+        const Result* r = &results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"ops_per_sec\": %.0f, "
+                   "\"ops\": %ld, \"runs\": %d, \"rss_delta_kb\": %ld",
+                r->name, r->ns_per_op, 1e9 / r->ns_per_op, r->ops, r->runs, r->rss_delta_kb);
+        if (compare && r->baseline_ns_per_op > 0) {
+            double change = (r->ns_per_op / r->baseline_ns_per_op - 1) * 100;
+            fprintf(f, ", \"baseline_ns_per_op\": %.2f, \"change_pct\": %.1f, \"regression\": %s",
+                    r->baseline_ns_per_op, change, change > threshold ? "true" : "false");
+        }
+        fprintf(f, "}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    int runs = 5;
+    const char* filter = NULL;
+    const char* out_path = NULL;
+    const char* baseline_path = NULL;
+    double threshold = 10.0;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--runs") == 0 && a + 1 < argc) {
+            runs = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--filter") == 0 && a + 1 < argc) {
+            filter = argv[++a];
+        } else if (strcmp(argv[a], "--out") == 0 && a + 1 < argc) {
+            out_path = argv[++a];
+        } else if (strcmp(argv[a], "--baseline") == 0 && a + 1 < argc) {
+            baseline_path = argv[++a];
+        } else if (strcmp(argv[a], "--threshold") == 0 && a + 1 < argc) {
+            threshold = atof(argv[++a]);
+        } else {
+            fprintf(stderr, "usage: %s [--runs N] [--filter substring] [--out file]"
+                            " [--baseline file [--threshold pct]]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (runs < 1 || runs > MAX_RUNS) {
+        fprintf(stderr, "--runs must be between 1 and %d\n", MAX_RUNS);
+        return 2;
+    }
+
+    char* baseline = NULL;
+    if (baseline_path && !(baseline = read_file(baseline_path))) {
+        fprintf(stderr, "Cannot read baseline %s (record one with --out)\n", baseline_path);
+        return 2;
+    }
+
+    Result results[MAX_RESULTS];
+    int count = 0;
+    int regressions = 0;
+
+    for (size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++) {
+        const Benchmark* bm = &benchmarks[b];
+        double samples[MAX_RUNS];
+        if (filter && !strstr(bm->name, filter)) continue;
+
+        long rss_before = slab_rss_kb();
+        bm->run(bm->ops / 10); // warm-up
+        for (int r = 0; r < runs; r++) {
+            samples[r] = bm->run(bm->ops) / bm->ops;
+        }
+        qsort(samples, runs, sizeof(double), compare_double);
+
+        Result* res = &results[count++];
+        res->name = bm->name;
+        res->ops = bm->ops;
+        res->runs = runs;
+        res->ns_per_op = samples[runs / 2];
+        res->rss_delta_kb = slab_rss_kb() - rss_before;
+        res->baseline_ns_per_op = baseline ? baseline_lookup(baseline, bm->name) : -1;
+
+        fprintf(stderr, "%-20s %10.1f ns/op %8ld KB rss", res->name, res->ns_per_op,
+                res->rss_delta_kb);
+        if (res->baseline_ns_per_op > 0) {
+            double change = (res->ns_per_op / res->baseline_ns_per_op - 1) * 100;
+            bool regressed = change > threshold;
+            regressions += regressed;
+            fprintf(stderr, "   baseline %10.1f   %+6.1f%% %s", res->baseline_ns_per_op, change,
+                    regressed ? "⚠️  REGRESSION" : "✓");
+        } else if (baseline) {
+            fprintf(stderr, "   (not in baseline)");
+        }
+        fprintf(stderr, "\n");
+    }
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Cannot write %s\n", out_path);
+        free(baseline);
+        return 2;
+    }
+    write_json(out, results, count, baseline != NULL, threshold);
+    if (out != stdout) fclose(out);
+
+    if (regressions) {
+        fprintf(stderr, "%d benchmark(s) regressed more than %.1f%%\n", regressions, threshold);
+    } else if (baseline) {
+        fprintf(stderr, "No regressions beyond %.1f%%\n", threshold);
+    }
+    free(baseline);
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,323 @@
+/*
+ * File: coro.c
+ * M:N scheduler, coroutine-aware semaphores and wait queues for coro.h.
+ *
+ * One run queue and one sleeper heap behind the scheduler lock; worker
+ * threads only hold it to pick the next task or to park a finished step.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "coro.h"
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Caller holds s->lock
+static uint64_t now_locked(CoScheduler* s) {
+    return s->virtual_time ? s->now : monotonic_ns() - s->epoch;
+}
+
+static void push_ready(CoScheduler* s, CoTask* t) {
+    t->next = NULL;
+    if (s->run_tail) {
+        s->run_tail->next = t;
+    } else {
+        s->run_head = t;
+    }
+    s->run_tail = t;
+    pthread_cond_signal(&s->work);
+}
+
+static CoTask* pop_ready(CoScheduler* s) {
+    CoTask* t = s->run_head;
+    if (t) {
+        s->run_head = t->next;
+        if (!s->run_head) s->run_tail = NULL;
+    }
+    return t;
+}
+
+static void heap_push(CoScheduler* s, CoTask* t) {
+    if (s->num_sleepers == s->sleeper_cap) {
+        s->sleeper_cap = s->sleeper_cap ? s->sleeper_cap * 2 : 1024;
+        s->sleepers = realloc(s->sleepers, s->sleeper_cap * sizeof(*s->sleepers));
+        if (!s->sleepers) {
+            perror("co_sleep");
+            abort();
+        }
+    }
+    size_t i = s->num_sleepers++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (s->sleepers[parent]->wake_at <= t->wake_at) break;
+        s->sleepers[i] = s->sleepers[parent];
+        i = parent;
+    }
+    s->sleepers[i] = t;
+}
+
+static CoTask* heap_pop(CoScheduler* s) {
+    CoTask* top = s->sleepers[0];
+    CoTask* last = s->sleepers[--s->num_sleepers];
+    size_t i = 0;
+
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= s->num_sleepers) break;
+        if (child + 1 < s->num_sleepers &&
+            s->sleepers[child + 1]->wake_at < s->sleepers[child]->wake_at) {
+            child++;
+        }
+        if (last->wake_at <= s->sleepers[child]->wake_at) break;
+        s->sleepers[i] = s->sleepers[child];
+        i = child;
+    }
+    if (s->num_sleepers > 0) s->sleepers[i] = last;
+    return top;
+}
+
+static void wake_due(CoScheduler* s) {
+    if (s->num_sleepers == 0) return;
+    uint64_t now = now_locked(s);
+    while (s->num_sleepers > 0 && s->sleepers[0]->wake_at <= now) {
+        push_ready(s, heap_pop(s));
+    }
+}
+
+static void* co_worker(void* arg) {
+    CoScheduler* s = arg;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        wake_due(s);
+        if (s->live == 0 || s->deadlock) break;
+
+        CoTask* t = pop_ready(s);
+        if (t) {
+            s->steps++;
+            pthread_mutex_unlock(&s->lock);
+            int r = t->step(t);
+            pthread_mutex_lock(&s->lock);
+
+            if (r == CO_READY) {
+                push_ready(s, t);
+            } else if (r == CO_DONE && --s->live == 0) {
+                pthread_cond_broadcast(&s->work);
+            }
+            continue;
+        }
+
+        // Nothing runnable. If every other worker is idle too, nobody can
+        // make a task runnable except the clock or a parked task's waker.
+        bool last_awake = s->idle + 1 == s->workers;
+        if (last_awake && s->num_sleepers == 0 && s->parked == 0) {
+            s->deadlock = true;
+            pthread_cond_broadcast(&s->work);
+            break;
+        }
+        if (last_awake && s->virtual_time && s->num_sleepers > 0) {
+            s->now = s->sleepers[0]->wake_at;
+            continue;
+        }
+
+        s->idle++;
+        if (!s->virtual_time && s->num_sleepers > 0) {
+            uint64_t at = s->epoch + s->sleepers[0]->wake_at;
+            struct timespec ts = { (time_t)(at / 1000000000ull), (long)(at % 1000000000ull) };
+            pthread_cond_timedwait(&s->work, &s->lock, &ts);
+        } else {
+            pthread_cond_wait(&s->work, &s->lock);
+        }
+        s->idle--;
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+void co_sched_init(CoScheduler* s, int workers, bool virtual_time) {
+    pthread_condattr_t ca;
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&s->work, &ca);
+    pthread_condattr_destroy(&ca);
+
+    s->run_head = s->run_tail = NULL;
+    s->sleepers = NULL;
+    s->num_sleepers = s->sleeper_cap = 0;
+    s->live = 0;
+    s->parked = 0;
+    s->workers = workers > 0 ? workers : 1;
+    s->idle = 0;
+    s->virtual_time = virtual_time;
+    s->deadlock = false;
+    s->now = 0;
+    s->epoch = monotonic_ns();
+    s->steps = 0;
+}
+
+void co_sched_destroy(CoScheduler* s) {
+    free(s->sleepers);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->work);
+}
+
+int co_sched_run(CoScheduler* s) {
+    pthread_t threads[s->workers];
+
+    for (int i = 0; i < s->workers; i++) {
+        pthread_create(&threads[i], NULL, co_worker, s);
+    }
+    for (int i = 0; i < s->workers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return s->deadlock ? -1 : 0;
+}
+
+void co_spawn(CoScheduler* s, CoTask* task, CoStep step) {
+    task->sched = s;
+    task->step = step;
+    task->resume = 0;
+    task->wake_at = 0;
+
+    pthread_mutex_lock(&s->lock);
+    s->live++;
+    push_ready(s, task);
+    pthread_mutex_unlock(&s->lock);
+}
+
+uint64_t co_now(CoScheduler* s) {
+    pthread_mutex_lock(&s->lock);
+    uint64_t now = now_locked(s);
+    pthread_mutex_unlock(&s->lock);
+    return now;
+}
+
+bool co_sleep(CoTask* task, uint64_t ns) {
+    CoScheduler* s = task->sched;
+
+    pthread_mutex_lock(&s->lock);
+    task->wake_at = now_locked(s) + ns;
+    heap_push(s, task);
+    pthread_cond_signal(&s->work); // a timed waiter may need to wake sooner
+    pthread_mutex_unlock(&s->lock);
+    return false;
+}
+
+void co_ready(CoTask* task) {
+    CoScheduler* s = task->sched;
+
+    pthread_mutex_lock(&s->lock);
+    push_ready(s, task);
+    pthread_mutex_unlock(&s->lock);
+}
+
+void co_sem_init(CoSem* sem, int count) {
+    pthread_mutex_init(&sem->lock, NULL);
+    sem->count = count;
+    sem->head = sem->tail = NULL;
+}
+
+void co_sem_destroy(CoSem* sem) {
+    pthread_mutex_destroy(&sem->lock);
+}
+
+bool co_sem_acquire(CoSem* sem, CoTask* task) {
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count > 0) {
+        sem->count--;
+        pthread_mutex_unlock(&sem->lock);
+        return true;
+    }
+    task->next = NULL;
+    if (sem->tail) {
+        sem->tail->next = task;
+    } else {
+        sem->head = task;
+    }
+    sem->tail = task;
+    pthread_mutex_unlock(&sem->lock);
+    return false;
+}
+
+bool co_sem_trywait(CoSem* sem) {
+    pthread_mutex_lock(&sem->lock);
+    bool taken = sem->count > 0;
+    if (taken) sem->count--;
+    pthread_mutex_unlock(&sem->lock);
+    return taken;
+}
+
+void co_sem_post(CoSem* sem) {
+    pthread_mutex_lock(&sem->lock);
+    CoTask* waiter = sem->head;
+    if (waiter) {
+        sem->head = waiter->next;
+        if (!sem->head) sem->tail = NULL;
+    } else {
+        sem->count++;
+    }
+    pthread_mutex_unlock(&sem->lock);
+
+    if (waiter) co_ready(waiter); // the unit goes straight to the waiter
+}
+
+void co_wait_init(CoWaitQueue* q) {
+    pthread_mutex_init(&q->lock, NULL);
+    q->wakeups = 0;
+    q->head = NULL;
+}
+
+void co_wait_destroy(CoWaitQueue* q) {
+    pthread_mutex_destroy(&q->lock);
+}
+
+unsigned long co_wait_ticket(CoWaitQueue* q) {
+    pthread_mutex_lock(&q->lock);
+    unsigned long ticket = q->wakeups;
+    pthread_mutex_unlock(&q->lock);
+    return ticket;
+}
+
+bool co_wait_park(CoWaitQueue* q, CoTask* task, unsigned long ticket) {
+    CoScheduler* s = task->sched;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->wakeups != ticket) {
+        pthread_mutex_unlock(&q->lock);
+        return true; // woken since the ticket was taken
+    }
+    task->next = q->head;
+    q->head = task;
+    // Counted before any co_wake_all can see the task
+    pthread_mutex_lock(&s->lock);
+    s->parked++;
+    pthread_mutex_unlock(&s->lock);
+    pthread_mutex_unlock(&q->lock);
+    return false;
+}
+
+void co_wake_all(CoWaitQueue* q) {
+    pthread_mutex_lock(&q->lock);
+    CoTask* task = q->head;
+    q->head = NULL;
+    q->wakeups++;
+    pthread_mutex_unlock(&q->lock);
+
+    while (task) {
+        CoTask* next = task->next; // push_ready reuses the link
+        CoScheduler* s = task->sched;
+
+        pthread_mutex_lock(&s->lock);
+        s->parked--;
+        push_ready(s, task);
+        pthread_mutex_unlock(&s->lock);
+        task = next;
+    }
+}
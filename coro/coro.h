@@ -0,0 +1,157 @@
+/*
+ * File: coro.h
+ * Stackless coroutines on an M:N scheduler.
+ *
+ * An actor is a struct that embeds a CoTask as its first member and a step
+ * function that runs it from its last suspension point. There is no stack
+ * per task: anything that must survive a suspension lives in the actor
+ * struct, so a task costs sizeof(CoTask) plus its own fields.
+ *
+ *   typedef struct { CoTask task; int round; } Walker;
+ *
+ *   int walker_step(CoTask* t) {
+ *       Walker* w = (Walker*)t;
+ *       CO_BEGIN(t);
+ *       for (w->round = 0; w->round < 3; w->round++) {
+ *           CO_SEM_WAIT(t, &door);     // suspends the task, not the thread
+ *           ...
+ *           co_sem_post(&door);
+ *           CO_SLEEP(t, 1000000);       // 1 ms on the scheduler's clock
+ *       }
+ *       CO_END(t);
+ *   }
+ *
+ * The step function's locals do not survive a CO_* suspension, and two
+ * CO_* macros must not share a source line (the resume point is __LINE__).
+ * A pthread mutex may be taken by a task as long as it is released before
+ * the next suspension.
+ *
+ * With virtual_time the clock jumps to the next sleeper whenever every
+ * worker is idle, so sleeps cost nothing in real time (discrete-event run).
+ *
+ * A CoWaitQueue parks tasks until an event raised by any thread, inside the
+ * scheduler or not. Tasks parked there never count as deadlocked; the
+ * workers wait for the wake-up instead.
+ */
+
+#ifndef CORO_H
+#define CORO_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+enum { CO_DONE, CO_READY, CO_BLOCKED };
+
+typedef struct CoTask CoTask;
+typedef struct CoScheduler CoScheduler;
+typedef int (*CoStep)(CoTask* task);
+
+struct CoTask {
+    CoTask* next;            // Run queue or wait list link
+    CoScheduler* sched;
+    CoStep step;
+    uint64_t wake_at;        // ns on the scheduler's clock while sleeping
+    unsigned resume;         // Source line to continue from, 0 = start
+};
+
+struct CoScheduler {
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    CoTask* run_head;
+    CoTask* run_tail;
+    CoTask** sleepers;       // Min-heap on wake_at
+    size_t num_sleepers;
+    size_t sleeper_cap;
+    long live;               // Spawned and not finished
+    long parked;             // On a CoWaitQueue, to be woken from outside
+    int workers;
+    int idle;
+    bool virtual_time;
+    bool deadlock;           // Tasks left but none runnable or sleeping
+    uint64_t now;            // Virtual clock, ns
+    uint64_t epoch;          // CLOCK_MONOTONIC at init, for the real clock
+    unsigned long steps;     // Task resumptions
+};
+
+void co_sched_init(CoScheduler* s, int workers, bool virtual_time);
+void co_sched_destroy(CoScheduler* s);
+
+// Runs until every task has finished; -1 if the remaining tasks deadlocked
+int co_sched_run(CoScheduler* s);
+
+// Queue a task (also from inside a running task)
+void co_spawn(CoScheduler* s, CoTask* task, CoStep step);
+
+uint64_t co_now(CoScheduler* s);
+
+// Suspension primitives behind the CO_* macros; false means "suspended"
+bool co_sleep(CoTask* task, uint64_t ns);
+void co_ready(CoTask* task);
+
+// Coroutine-aware counting semaphore: a waiter is parked on the semaphore
+// and handed the unit directly by co_sem_post
+typedef struct {
+    pthread_mutex_t lock;
+    int count;
+    CoTask* head;
+    CoTask* tail;
+} CoSem;
+
+void co_sem_init(CoSem* sem, int count);
+void co_sem_destroy(CoSem* sem);
+bool co_sem_acquire(CoSem* sem, CoTask* task);
+bool co_sem_trywait(CoSem* sem);
+void co_sem_post(CoSem* sem);
+
+// Coroutine-aware mutex: a binary CoSem
+typedef struct {
+    CoSem sem;
+} CoMutex;
+
+// Coroutine-aware wait queue: take a ticket, check the condition, then
+// park with that ticket. A wake-up between the check and the park is not
+// lost; co_wait_park returns true and the task checks again.
+typedef struct {
+    pthread_mutex_t lock;
+    unsigned long wakeups;
+    CoTask* head;
+} CoWaitQueue;
+
+void co_wait_init(CoWaitQueue* q);
+void co_wait_destroy(CoWaitQueue* q);
+unsigned long co_wait_ticket(CoWaitQueue* q);
+bool co_wait_park(CoWaitQueue* q, CoTask* task, unsigned long ticket);
+// Make every parked task runnable; callable from any thread
+void co_wake_all(CoWaitQueue* q);
+
+#define co_mutex_init(m)    co_sem_init(&(m)->sem, 1)
+#define co_mutex_destroy(m) co_sem_destroy(&(m)->sem)
+#define co_mutex_unlock(m)  co_sem_post(&(m)->sem)
+
+#define CO_BEGIN(t) switch ((t)->resume) { case 0:
+#define CO_END(t)   } (t)->resume = 0; return CO_DONE
+
+// Suspend if blocked is true; resume right after the macro when woken
+#define CO_SUSPEND_IF(t, blocked) \
+    do {                                                                     \
+        (t)->resume = __LINE__;                                              \
+        if (blocked) return CO_BLOCKED;                                      \
+        __attribute__((fallthrough));                                        \
+        case __LINE__:;                                                      \
+    } while (0)
+
+#define CO_YIELD(t) \
+    do {                                                                     \
+        (t)->resume = __LINE__;                                              \
+        return CO_READY;                                                     \
+        case __LINE__:;                                                      \
+    } while (0)
+
+#define CO_SLEEP(t, ns)     CO_SUSPEND_IF(t, !co_sleep((t), (ns)))
+#define CO_SEM_WAIT(t, sem) CO_SUSPEND_IF(t, !co_sem_acquire((sem), (t)))
+#define CO_LOCK(t, m)       CO_SEM_WAIT(t, &(m)->sem)
+#define CO_WAIT(t, q, tk)   CO_SUSPEND_IF(t, !co_wait_park((q), (t), (tk)))
+
+#endif
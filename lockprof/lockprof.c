@@ -0,0 +1,601 @@
+/*
+ * File: lockprof.c
+ * Lock contention profiler. Stats live in fixed-size open-addressing
+ * tables keyed by lock address and by (lock, call site); every counter is
+ * a relaxed atomic, so the uncontended path costs one trylock, two clock
+ * reads per lock/unlock pair and a few atomic adds.
+ *
+ * A destroyed lock's entry and sites are folded into rows of the retired
+ * table (keyed by lock name) and their slots become tombstones, which
+ * lookups probe past and registration reuses.
+ *
+ * A forked child keeps the tables' keys but starts its counters from zero
+ * and gets its own signal thread, so each process reports only its own
+ * locking, once.
+ */
+
+#define LOCKPROF_IMPL
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "lockprof.h"
+
+#define MAX_LOCKS 1024      // power of two
+#define MAX_SITES 4096      // power of two
+#define BUCKETS   40        // log2 ns buckets, the last one is open-ended
+#define TOP_SITES 20
+
+enum { KIND_MUTEX, KIND_SEM };
+
+#define FREED_LOCK ((const void*)1)  // tombstone in a lock table
+#define FREED_SITE 2ull              // tombstone in the site table (live keys are odd)
+
+typedef struct {
+    atomic_ulong count;
+    atomic_ulong total_ns;
+    atomic_ulong max_ns;
+    atomic_ulong hist[BUCKETS];
+} Timing;
+
+typedef struct LockStats {
+    _Atomic(const void*) addr;
+    _Atomic(const char*) name;
+    atomic_int kind;
+    atomic_bool tracks_hold;        // mutexes and binary semaphores
+    atomic_ulong acquisitions;
+    atomic_ulong contended;
+    atomic_ulong try_failures;
+    Timing wait;
+    Timing hold;
+    atomic_ulong acquired_at;       // ns, 0 when not held
+    _Atomic(struct SiteStats*) holder;
+    atomic_ulong destroyed;         // retired rows: locks folded in
+} LockStats;
+
+typedef struct SiteStats {
+    atomic_ulong key;               // 0 = never used, FREED_SITE = freed
+    atomic_bool ready;
+    _Atomic(LockStats*) lock;
+    const char* file;
+    int line;
+    atomic_ulong acquisitions;
+    atomic_ulong contended;
+    atomic_ulong wait_ns;
+    atomic_ulong hold_ns;
+} SiteStats;
+
+static LockStats locks[MAX_LOCKS];
+static LockStats retired[MAX_LOCKS]; // destroyed locks, one row per name
+static SiteStats sites[MAX_SITES];
+static atomic_ulong dropped;        // events lost to full tables
+static atomic_bool exiting_on_signal;
+static sigset_t report_signals;     // blocked everywhere, taken by signal_thread
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+static inline int bucket_of(uint64_t ns) {
+    int b = ns ? 64 - __builtin_clzll(ns) : 0;
+    return b < BUCKETS ? b : BUCKETS - 1;
+}
+
+static inline void record(Timing* t, uint64_t ns) {
+    atomic_fetch_add_explicit(&t->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&t->total_ns, ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&t->hist[bucket_of(ns)], 1, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&t->max_ns, memory_order_relaxed);
+    while (ns > max && !atomic_compare_exchange_weak_explicit(&t->max_ns, &max, ns,
+                                                             memory_order_relaxed,
+                                                             memory_order_relaxed)) {
+    }
+}
+
+// Claims a never-used or freed slot for key
+static bool claim_lock(LockStats* e, const void** cur, const void* key, const char* name, int kind) {
+    if (!atomic_compare_exchange_strong(&e->addr, cur, key)) return false;
+    atomic_store(&e->kind, kind);
+    atomic_store(&e->tracks_hold, kind == KIND_MUTEX);
+    const char* expected = NULL;
+    atomic_compare_exchange_strong(&e->name, &expected, name);
+    return true;
+}
+
+// Finds, or registers when create is set, the entry for key in table
+// (locks: the lock address; retired: the lock name)
+static LockStats* find_lock(LockStats* table, const void* key, const char* name, int kind, bool create) {
+    uint64_t h = mix((uintptr_t)key);
+    LockStats* freed = NULL;
+    for (int probe = 0; probe < MAX_LOCKS; probe++) {
+        LockStats* e = &table[(h + probe) & (MAX_LOCKS - 1)];
+        const void* cur = atomic_load_explicit(&e->addr, memory_order_acquire);
+        if (cur == key) return e;
+        if (cur == FREED_LOCK) {
+            if (!freed) freed = e;
+            continue;
+        }
+        if (cur != NULL) continue;
+        if (!create) return NULL;
+
+        // Not in the table: take the first freed slot on the way, else this one
+        LockStats* slot = freed ? freed : e;
+        cur = freed ? FREED_LOCK : NULL;
+        if (claim_lock(slot, &cur, key, name, kind) || cur == key) return slot;
+        // Another lock got there first; look again
+        freed = NULL;
+        probe = -1;
+    }
+    if (create && freed) {
+        const void* cur = FREED_LOCK;
+        if (claim_lock(freed, &cur, key, name, kind) || cur == key) return freed;
+    }
+    if (create) atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+    return NULL;
+}
+
+static LockStats* lock_stats(const void* addr, const char* name, int kind) {
+    return find_lock(locks, addr, name, kind, true);
+}
+
+// Finds or registers the stats of one call site on one lock
+static SiteStats* site_stats(LockStats* lock, const char* file, int line) {
+    uint64_t key = mix((uintptr_t)lock ^ mix((uintptr_t)file) ^ (uint64_t)line) | 1;
+    SiteStats* freed = NULL;
+    for (int probe = 0; probe < MAX_SITES; probe++) {
+        SiteStats* s = &sites[(key + probe) & (MAX_SITES - 1)];
+        uint64_t cur = atomic_load_explicit(&s->key, memory_order_acquire);
+        if (cur == key) return s;
+        if (cur == FREED_SITE) {
+            if (!freed) freed = s;
+            continue;
+        }
+        if (cur != 0) continue;
+
+        SiteStats* slot = freed ? freed : s;
+        cur = freed ? FREED_SITE : 0;
+        if (atomic_compare_exchange_strong(&slot->key, &cur, key)) {
+            atomic_store_explicit(&slot->lock, lock, memory_order_relaxed);
+            slot->file = file;
+            slot->line = line;
+            atomic_store_explicit(&slot->ready, true, memory_order_release);
+            return slot;
+        }
+        if (cur == key) return slot;
+        freed = NULL;
+        probe = -1;
+    }
+    atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+    return NULL;
+}
+
+static void merge_timing(Timing* to, Timing* from) {
+    atomic_fetch_add(&to->count, atomic_exchange(&from->count, 0));
+    atomic_fetch_add(&to->total_ns, atomic_exchange(&from->total_ns, 0));
+    uint64_t max = atomic_exchange(&from->max_ns, 0);
+    uint64_t cur = atomic_load(&to->max_ns);
+    while (max > cur && !atomic_compare_exchange_weak(&to->max_ns, &cur, max)) {
+    }
+    for (int b = 0; b < BUCKETS; b++) {
+        atomic_fetch_add(&to->hist[b], atomic_exchange(&from->hist[b], 0));
+    }
+}
+
+// Moves the numbers of a site of a destroyed lock to the same site on its
+// retired row (or drops them if there is none) and frees the slot
+static void retire_site(SiteStats* s, LockStats* row) {
+    SiteStats* to = row ? site_stats(row, s->file, s->line) : NULL;
+    uint64_t acquisitions = atomic_exchange(&s->acquisitions, 0);
+    uint64_t contended = atomic_exchange(&s->contended, 0);
+    uint64_t wait = atomic_exchange(&s->wait_ns, 0);
+    uint64_t hold = atomic_exchange(&s->hold_ns, 0);
+    if (to) {
+        atomic_fetch_add(&to->acquisitions, acquisitions);
+        atomic_fetch_add(&to->contended, contended);
+        atomic_fetch_add(&to->wait_ns, wait);
+        atomic_fetch_add(&to->hold_ns, hold);
+    }
+    atomic_store(&s->ready, false);
+    atomic_store(&s->lock, NULL);
+    atomic_store_explicit(&s->key, FREED_SITE, memory_order_release);
+}
+
+// A lock is being destroyed: fold it into the retired row of its name so
+// the report keeps its numbers, and free its slot for the next lock at
+// this address, which must not inherit them
+static void retire_lock(const void* addr) {
+    LockStats* e = find_lock(locks, addr, NULL, KIND_MUTEX, false);
+    if (!e) return;
+
+    const char* name = atomic_load(&e->name);
+    int kind = atomic_load(&e->kind);
+    LockStats* row = find_lock(retired, name ? name : "?", name, kind, true);
+    if (row) {
+        atomic_store(&row->tracks_hold, atomic_load(&e->tracks_hold));
+        atomic_fetch_add(&row->destroyed, 1);
+        atomic_fetch_add(&row->acquisitions, atomic_exchange(&e->acquisitions, 0));
+        atomic_fetch_add(&row->contended, atomic_exchange(&e->contended, 0));
+        atomic_fetch_add(&row->try_failures, atomic_exchange(&e->try_failures, 0));
+        merge_timing(&row->wait, &e->wait);
+        merge_timing(&row->hold, &e->hold);
+    }
+    for (int i = 0; i < MAX_SITES; i++) {
+        if (atomic_load(&sites[i].ready) && atomic_load(&sites[i].lock) == e) retire_site(&sites[i], row);
+    }
+
+    // Whatever a missing row could not take is simply reset
+    atomic_store(&e->acquisitions, 0);
+    atomic_store(&e->contended, 0);
+    atomic_store(&e->try_failures, 0);
+    memset(&e->wait, 0, sizeof(e->wait));
+    memset(&e->hold, 0, sizeof(e->hold));
+    atomic_store(&e->acquired_at, 0);
+    atomic_store(&e->holder, NULL);
+    atomic_store(&e->name, NULL);
+    atomic_store_explicit(&e->addr, FREED_LOCK, memory_order_release);
+}
+
+static void on_acquired(LockStats* e, SiteStats* s, bool contended, uint64_t wait) {
+    atomic_fetch_add_explicit(&e->acquisitions, 1, memory_order_relaxed);
+    record(&e->wait, wait);
+    if (contended) atomic_fetch_add_explicit(&e->contended, 1, memory_order_relaxed);
+    if (s) {
+        atomic_fetch_add_explicit(&s->acquisitions, 1, memory_order_relaxed);
+        if (contended) atomic_fetch_add_explicit(&s->contended, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&s->wait_ns, wait, memory_order_relaxed);
+    }
+    if (atomic_load_explicit(&e->tracks_hold, memory_order_relaxed)) {
+        atomic_store_explicit(&e->holder, s, memory_order_relaxed);
+        atomic_store_explicit(&e->acquired_at, now_ns(), memory_order_relaxed);
+    }
+}
+
+// Back from a condition wait: the mutex is held again, but getting it back
+// is part of the wait, not a new acquisition
+static void on_reacquired(LockStats* e, SiteStats* s) {
+    if (!atomic_load_explicit(&e->tracks_hold, memory_order_relaxed)) return;
+    atomic_store_explicit(&e->holder, s, memory_order_relaxed);
+    atomic_store_explicit(&e->acquired_at, now_ns(), memory_order_relaxed);
+}
+
+static void on_released(LockStats* e) {
+    if (!e || !atomic_load_explicit(&e->tracks_hold, memory_order_relaxed)) return;
+    uint64_t since = atomic_exchange_explicit(&e->acquired_at, 0, memory_order_relaxed);
+    if (!since) return;
+    uint64_t held = now_ns() - since;
+    record(&e->hold, held);
+    SiteStats* s = atomic_load_explicit(&e->holder, memory_order_relaxed);
+    if (s) atomic_fetch_add_explicit(&s->hold_ns, held, memory_order_relaxed);
+}
+
+int lockprof_mutex_init(pthread_mutex_t* m, const pthread_mutexattr_t* attr,
+                        const char* name, const char* file, int line) {
+    (void)file;
+    (void)line;
+    lock_stats(m, name, KIND_MUTEX);
+    return pthread_mutex_init(m, attr);
+}
+
+int lockprof_mutex_lock(pthread_mutex_t* m, const char* name, const char* file, int line) {
+    LockStats* e = lock_stats(m, name, KIND_MUTEX);
+    if (!e) return pthread_mutex_lock(m);
+    SiteStats* s = site_stats(e, file, line);
+
+    int rc = pthread_mutex_trylock(m);
+    if (rc == 0) {
+        on_acquired(e, s, false, 0);
+        return 0;
+    }
+    if (rc != EBUSY) return rc;
+
+    uint64_t start = now_ns();
+    rc = pthread_mutex_lock(m);
+    if (rc == 0) on_acquired(e, s, true, now_ns() - start);
+    return rc;
+}
+
+int lockprof_mutex_trylock(pthread_mutex_t* m, const char* name, const char* file, int line) {
+    LockStats* e = lock_stats(m, name, KIND_MUTEX);
+    int rc = pthread_mutex_trylock(m);
+    if (!e) return rc;
+    if (rc == 0) on_acquired(e, site_stats(e, file, line), false, 0);
+    else atomic_fetch_add_explicit(&e->try_failures, 1, memory_order_relaxed);
+    return rc;
+}
+
+int lockprof_mutex_unlock(pthread_mutex_t* m) {
+    on_released(lock_stats(m, NULL, KIND_MUTEX));
+    return pthread_mutex_unlock(m);
+}
+
+int lockprof_mutex_destroy(pthread_mutex_t* m) {
+    retire_lock(m);
+    return pthread_mutex_destroy(m);
+}
+
+// The condition wait gives the mutex up: end the hold before it and start
+// a new one after, so time spent waiting for the condition is not hold time
+int lockprof_cond_wait(pthread_cond_t* c, pthread_mutex_t* m, const char* file, int line) {
+    LockStats* e = lock_stats(m, NULL, KIND_MUTEX);
+    if (!e) return pthread_cond_wait(c, m);
+    on_released(e);
+    int rc = pthread_cond_wait(c, m);
+    on_reacquired(e, site_stats(e, file, line));
+    return rc;
+}
+
+int lockprof_cond_timedwait(pthread_cond_t* c, pthread_mutex_t* m, const struct timespec* abstime,
+                            const char* file, int line) {
+    LockStats* e = lock_stats(m, NULL, KIND_MUTEX);
+    if (!e) return pthread_cond_timedwait(c, m, abstime);
+    on_released(e);
+    int rc = pthread_cond_timedwait(c, m, abstime);
+    on_reacquired(e, site_stats(e, file, line));
+    return rc;
+}
+
+int lockprof_sem_init(sem_t* s, int pshared, unsigned value,
+                      const char* name, const char* file, int line) {
+    (void)file;
+    (void)line;
+    LockStats* e = lock_stats(s, name, KIND_SEM);
+    if (e) atomic_store(&e->tracks_hold, value == 1); // binary semaphore used as a lock
+    return sem_init(s, pshared, value);
+}
+
+int lockprof_sem_wait(sem_t* s, const char* name, const char* file, int line) {
+    LockStats* e = lock_stats(s, name, KIND_SEM);
+    if (!e) return sem_wait(s);
+    SiteStats* site = site_stats(e, file, line);
+
+    if (sem_trywait(s) == 0) {
+        on_acquired(e, site, false, 0);
+        return 0;
+    }
+    uint64_t start = now_ns();
+    int rc;
+    while ((rc = sem_wait(s)) != 0 && errno == EINTR) {
+    }
+    if (rc == 0) on_acquired(e, site, true, now_ns() - start);
+    return rc;
+}
+
+int lockprof_sem_trywait(sem_t* s, const char* name, const char* file, int line) {
+    LockStats* e = lock_stats(s, name, KIND_SEM);
+    int rc = sem_trywait(s);
+    if (!e) return rc;
+    if (rc == 0) on_acquired(e, site_stats(e, file, line), false, 0);
+    else atomic_fetch_add_explicit(&e->try_failures, 1, memory_order_relaxed);
+    return rc;
+}
+
+int lockprof_sem_post(sem_t* s) {
+    on_released(lock_stats(s, NULL, KIND_SEM));
+    return sem_post(s);
+}
+
+int lockprof_sem_destroy(sem_t* s) {
+    retire_lock(s);
+    return sem_destroy(s);
+}
+
+void lockprof_name(const void* lock, const char* fmt, ...) {
+    char buf[64];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    LockStats* e = lock_stats(lock, NULL, KIND_MUTEX);
+    char* name = strdup(buf); // lives as long as the process
+    if (e && name) atomic_store(&e->name, name);
+}
+
+// Upper bound (ns) of the bucket holding the q-th quantile, capped at the max
+static uint64_t quantile(const Timing* t, double q) {
+    uint64_t n = atomic_load_explicit(&t->count, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&t->max_ns, memory_order_relaxed);
+    if (n == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (n - 1)) + 1, seen = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+        seen += atomic_load_explicit(&t->hist[b], memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t bound = b ? 1ull << b : 0;
+            return bound < max ? bound : max;
+        }
+    }
+    return max;
+}
+
+static uint64_t load(atomic_ulong* v) {
+    return atomic_load_explicit(v, memory_order_relaxed);
+}
+
+static int by_lock_wait(const void* a, const void* b) {
+    uint64_t x = load(&(*(LockStats* const*)a)->wait.total_ns);
+    uint64_t y = load(&(*(LockStats* const*)b)->wait.total_ns);
+    if (x != y) return x < y ? 1 : -1;
+    x = load(&(*(LockStats* const*)a)->acquisitions);
+    y = load(&(*(LockStats* const*)b)->acquisitions);
+    return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+static int by_site_wait(const void* a, const void* b) {
+    uint64_t x = load(&(*(SiteStats* const*)a)->wait_ns);
+    uint64_t y = load(&(*(SiteStats* const*)b)->wait_ns);
+    if (x != y) return x < y ? 1 : -1;
+    x = load(&(*(SiteStats* const*)a)->contended);
+    y = load(&(*(SiteStats* const*)b)->contended);
+    return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+static bool is_retired(const LockStats* e) {
+    return e >= retired && e < retired + MAX_LOCKS;
+}
+
+// Retired rows say how many destroyed locks they hold
+static const char* lock_name(LockStats* e, char* buf, size_t size) {
+    const char* name = atomic_load(&e->name);
+    if (!name) name = "?";
+    if (name[0] == '&') name++;
+    if (!is_retired(e)) return name;
+    snprintf(buf, size, "%s (%lu destroyed)", name, atomic_load(&e->destroyed));
+    return buf;
+}
+
+void lockprof_report(void) {
+    static LockStats* order[2 * MAX_LOCKS];
+    static SiteStats* site_order[MAX_SITES];
+    static pthread_mutex_t report_mutex = PTHREAD_MUTEX_INITIALIZER;
+    int n = 0, ns = 0;
+
+    pthread_mutex_lock(&report_mutex);
+    for (int i = 0; i < MAX_LOCKS; i++) {
+        const void* addr = atomic_load(&locks[i].addr);
+        if (addr && addr != FREED_LOCK && load(&locks[i].acquisitions)) order[n++] = &locks[i];
+        if (atomic_load(&retired[i].addr) && load(&retired[i].acquisitions)) order[n++] = &retired[i];
+    }
+    for (int i = 0; i < MAX_SITES; i++) {
+        if (atomic_load(&sites[i].ready) && atomic_load(&sites[i].lock) && load(&sites[i].acquisitions)) {
+            site_order[ns++] = &sites[i];
+        }
+    }
+    qsort(order, n, sizeof(order[0]), by_lock_wait);
+    qsort(site_order, ns, sizeof(site_order[0]), by_site_wait);
+
+    fprintf(stderr, "\n=== LOCK CONTENTION REPORT (pid %ld) ===\n", (long)getpid());
+    fprintf(stderr, "%-28s %5s %10s %10s %6s %11s %9s %9s %9s %9s %9s\n",
+            "Lock", "Kind", "Acquired", "Contended", "%", "Wait ms", "Wait p50", "Wait p99",
+            "Wait max", "Hold p50", "Hold p99");
+    for (int i = 0; i < n; i++) {
+        LockStats* e = order[i];
+        uint64_t acq = load(&e->acquisitions), cont = load(&e->contended);
+        bool hold = atomic_load(&e->tracks_hold);
+        char name[64];
+        fprintf(stderr, "%-28.28s %5s %10lu %10lu %5.1f%% %11.3f %7.1fus %7.1fus %7.1fus",
+                lock_name(e, name, sizeof(name)), atomic_load(&e->kind) == KIND_MUTEX ? "mutex" : "sem",
+                acq, cont, acq ? 100.0 * cont / acq : 0.0,
+                load(&e->wait.total_ns) / 1e6,
+                quantile(&e->wait, 0.50) / 1e3, quantile(&e->wait, 0.99) / 1e3,
+                load(&e->wait.max_ns) / 1e3);
+        if (hold) {
+            fprintf(stderr, " %7.1fus %7.1fus\n",
+                    quantile(&e->hold, 0.50) / 1e3, quantile(&e->hold, 0.99) / 1e3);
+        } else {
+            fprintf(stderr, " %9s %9s\n", "--", "--");
+        }
+    }
+
+    fprintf(stderr, "\nTop call sites by wait time:\n");
+    fprintf(stderr, "%-36s %-28s %10s %10s %11s %11s\n",
+            "Site", "Lock", "Acquired", "Contended", "Wait ms", "Hold ms");
+    for (int i = 0; i < ns && i < TOP_SITES; i++) {
+        SiteStats* s = site_order[i];
+        char where[64];
+        char name[64];
+        const char* file = strrchr(s->file, '/');
+        snprintf(where, sizeof(where), "%s:%d", file ? file + 1 : s->file, s->line);
+        fprintf(stderr, "%-36.36s %-28.28s %10lu %10lu %11.3f %11.3f\n",
+                where, lock_name(atomic_load(&s->lock), name, sizeof(name)),
+                load(&s->acquisitions), load(&s->contended),
+                load(&s->wait_ns) / 1e6, load(&s->hold_ns) / 1e6);
+    }
+    if (load(&dropped)) {
+        fprintf(stderr, "(%lu events not recorded: lock or site table full)\n", load(&dropped));
+    }
+    pthread_mutex_unlock(&report_mutex);
+}
+
+static void report_at_exit(void) {
+    if (!atomic_load(&exiting_on_signal)) lockprof_report();
+}
+
+// Signals are blocked everywhere and taken synchronously here, so the
+// report is written from a normal thread rather than a signal handler
+static void* signal_thread(void* arg) {
+    int sig;
+    (void)arg;
+    for (;;) {
+        if (sigwait(&report_signals, &sig) != 0) continue;
+        lockprof_report();
+        if (sig != SIGUSR1) {
+            atomic_store(&exiting_on_signal, true);
+            exit(128 + sig);
+        }
+    }
+    return NULL;
+}
+
+static void start_signal_thread(void) {
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, signal_thread, NULL) == 0) {
+        pthread_detach(tid);
+    }
+}
+
+static void reset_timing(Timing* t) {
+    atomic_store_explicit(&t->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->total_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&t->max_ns, 0, memory_order_relaxed);
+    for (int b = 0; b < BUCKETS; b++) {
+        atomic_store_explicit(&t->hist[b], 0, memory_order_relaxed);
+    }
+}
+
+static void reset_lock(LockStats* e) {
+    atomic_store_explicit(&e->acquisitions, 0, memory_order_relaxed);
+    atomic_store_explicit(&e->contended, 0, memory_order_relaxed);
+    atomic_store_explicit(&e->try_failures, 0, memory_order_relaxed);
+    atomic_store_explicit(&e->destroyed, 0, memory_order_relaxed);
+    reset_timing(&e->wait);
+    reset_timing(&e->hold);
+}
+
+// Child side of fork(): only the forking thread exists, so the signal
+// thread is gone while the signals stay blocked. Start a new one, and
+// drop the parent's counts so both processes do not report them.
+static void lockprof_child(void) {
+    for (int i = 0; i < MAX_LOCKS; i++) {
+        reset_lock(&locks[i]);
+        reset_lock(&retired[i]);
+    }
+    for (int i = 0; i < MAX_SITES; i++) {
+        atomic_store_explicit(&sites[i].acquisitions, 0, memory_order_relaxed);
+        atomic_store_explicit(&sites[i].contended, 0, memory_order_relaxed);
+        atomic_store_explicit(&sites[i].wait_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&sites[i].hold_ns, 0, memory_order_relaxed);
+    }
+    atomic_store(&dropped, 0);
+    start_signal_thread();
+}
+
+__attribute__((constructor))
+static void lockprof_start(void) {
+    sigemptyset(&report_signals);
+    sigaddset(&report_signals, SIGUSR1);
+    sigaddset(&report_signals, SIGINT);
+    sigaddset(&report_signals, SIGTERM);
+    // Inherited by every thread the program creates from here on
+    pthread_sigmask(SIG_BLOCK, &report_signals, NULL);
+    start_signal_thread();
+    pthread_atfork(NULL, NULL, lockprof_child);
+    atexit(report_at_exit);
+}
@@ -0,0 +1,78 @@
+/*
+ * File: lockprof.h
+ * Lock contention profiler for pthread mutexes and POSIX semaphores.
+ *
+ * Include this header after the system headers and build with -DLOCKPROF
+ * plus lockprof.c: every pthread_mutex_* and sem_* call in the file is
+ * routed through the profiler, which records per lock and per call site
+ *   - acquisitions and contended acquisitions (had to wait)
+ *   - wait-time and hold-time log2 histograms (ns)
+ * Without -DLOCKPROF the header expands to nothing.
+ *
+ * pthread_cond_wait/timedwait on a profiled mutex end the hold when they
+ * release it and start a new one once they get it back; the time spent
+ * waiting for the condition counts as neither wait nor hold. Destroying a
+ * lock frees its table entry for the next lock at that address and folds
+ * its numbers into a "(N destroyed)" row shared by destroyed locks of the
+ * same name.
+ *
+ * The report, sorted by total wait time, goes to stderr at exit, on
+ * SIGUSR1 (keeps running) and on SIGINT/SIGTERM (then exits).
+ */
+
+#ifndef LOCKPROF_H
+#define LOCKPROF_H
+
+#ifdef LOCKPROF
+
+#include <pthread.h>
+#include <semaphore.h>
+
+int lockprof_mutex_init(pthread_mutex_t* m, const pthread_mutexattr_t* attr,
+                        const char* name, const char* file, int line);
+int lockprof_mutex_lock(pthread_mutex_t* m, const char* name, const char* file, int line);
+int lockprof_mutex_trylock(pthread_mutex_t* m, const char* name, const char* file, int line);
+int lockprof_mutex_unlock(pthread_mutex_t* m);
+int lockprof_mutex_destroy(pthread_mutex_t* m);
+
+int lockprof_cond_wait(pthread_cond_t* c, pthread_mutex_t* m, const char* file, int line);
+int lockprof_cond_timedwait(pthread_cond_t* c, pthread_mutex_t* m, const struct timespec* abstime,
+                            const char* file, int line);
+
+int lockprof_sem_init(sem_t* s, int pshared, unsigned value,
+                      const char* name, const char* file, int line);
+int lockprof_sem_wait(sem_t* s, const char* name, const char* file, int line);
+int lockprof_sem_trywait(sem_t* s, const char* name, const char* file, int line);
+int lockprof_sem_post(sem_t* s);
+int lockprof_sem_destroy(sem_t* s);
+
+// Gives a lock a readable name in the report (e.g. "gate_mutex A1")
+void lockprof_name(const void* lock, const char* fmt, ...);
+
+// Writes the report to stderr now
+void lockprof_report(void);
+
+#ifndef LOCKPROF_IMPL
+#define pthread_mutex_init(m, a) lockprof_mutex_init((m), (a), #m, __FILE__, __LINE__)
+#define pthread_mutex_lock(m)    lockprof_mutex_lock((m), #m, __FILE__, __LINE__)
+#define pthread_mutex_trylock(m) lockprof_mutex_trylock((m), #m, __FILE__, __LINE__)
+#define pthread_mutex_unlock(m)  lockprof_mutex_unlock(m)
+#define pthread_mutex_destroy(m) lockprof_mutex_destroy(m)
+#define pthread_cond_wait(c, m)  lockprof_cond_wait((c), (m), __FILE__, __LINE__)
+#define pthread_cond_timedwait(c, m, t) lockprof_cond_timedwait((c), (m), (t), __FILE__, __LINE__)
+#define sem_init(s, p, v)        lockprof_sem_init((s), (p), (v), #s, __FILE__, __LINE__)
+#define sem_wait(s)              lockprof_sem_wait((s), #s, __FILE__, __LINE__)
+#define sem_trywait(s)           lockprof_sem_trywait((s), #s, __FILE__, __LINE__)
+#define sem_post(s)              lockprof_sem_post(s)
+#define sem_destroy(s)           lockprof_sem_destroy(s)
+#endif
+
+#define LOCKPROF_NAME(lock, ...) lockprof_name((lock), __VA_ARGS__)
+
+#else
+
+#define LOCKPROF_NAME(lock, ...) ((void)0)
+
+#endif
+
+#endif
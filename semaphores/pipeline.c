@@ -0,0 +1,279 @@
+/*
+ * File: pipeline.c
+ * Stage workers, bounded queues and gauges for pipeline.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pipeline.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Only pay for a clock read when the semaphore actually blocks
+static void timed_wait(sem_t* s, atomic_ulong* waited) {
+    if (sem_trywait(s) == 0) return;
+    uint64_t t0 = now_ns();
+    sem_wait(s);
+    atomic_fetch_add_explicit(waited, now_ns() - t0, memory_order_relaxed);
+}
+
+// Caller holds q->lock
+static void account_depth(PipeQueue* q) {
+    uint64_t now = now_ns();
+    q->depth_ns += (uint64_t)q->depth * (now - q->last_change_ns);
+    q->last_change_ns = now;
+}
+
+static void queue_push(PipeQueue* q, PipeSlot slot, atomic_ulong* waited) {
+    //wait for an empty slot: a full queue is the backpressure
+    timed_wait(&q->empty, waited);
+    sem_wait(&q->lock);
+    account_depth(q);
+    q->slots[(q->head + q->depth) % q->capacity] = slot;
+    q->depth++;
+    sem_post(&q->lock);
+    sem_post(&q->full);
+}
+
+static PipeSlot queue_pop(PipeQueue* q, atomic_ulong* waited) {
+    timed_wait(&q->full, waited);
+    sem_wait(&q->lock);
+    account_depth(q);
+    PipeSlot slot = q->slots[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->depth--;
+    sem_post(&q->lock);
+    sem_post(&q->empty);
+    return slot;
+}
+
+// Called once, by whoever takes the stage's running count to zero: close
+// the stream for the next stage; everything the stage sent is already
+// queued ahead of the markers
+static void stage_finished(Pipeline* p, PipeStage* st) {
+    if (st->kind != STAGE_SINK) {
+        int downstream = p->stages[st->index + 1].parallelism;
+        for (int i = 0; i < downstream; i++) {
+            queue_push(&p->queues[st->index + 1], (PipeSlot){ NULL, true }, &st->wait_out_ns);
+        }
+    } else {
+        p->end_ns = now_ns();
+        atomic_store(&p->done, true);
+    }
+}
+
+static void* stage_worker(void* arg) {
+    PipeStage* st = arg;
+    Pipeline* p = st->owner;
+    PipeQueue* in = st->kind == STAGE_SOURCE ? NULL : &p->queues[st->index];
+    PipeQueue* out = st->kind == STAGE_SINK ? NULL : &p->queues[st->index + 1];
+
+    for (;;) {
+        void* item = NULL;
+        void* result = NULL;
+        bool forward;
+
+        if (in) {
+            PipeSlot slot = queue_pop(in, &st->wait_in_ns);
+            if (slot.end) break;
+            item = slot.item;
+        }
+
+        uint64_t t0 = now_ns();
+        switch (st->kind) {
+        case STAGE_SOURCE:
+            forward = !atomic_load_explicit(&p->stopping, memory_order_relaxed) &&
+                      ((PipeSourceFn)st->fn)(st->ctx, &result);
+            break;
+        case STAGE_TRANSFORM:
+            forward = ((PipeTransformFn)st->fn)(st->ctx, item, &result);
+            break;
+        default:
+            ((PipeSinkFn)st->fn)(st->ctx, item);
+            forward = false;
+            break;
+        }
+        atomic_fetch_add_explicit(&st->busy_ns, now_ns() - t0, memory_order_relaxed);
+
+        if (st->kind == STAGE_SOURCE && !forward) break; // end of stream
+        atomic_fetch_add_explicit(&st->processed, 1, memory_order_relaxed);
+
+        if (out && forward) {
+            queue_push(out, (PipeSlot){ result, false }, &st->wait_out_ns);
+        }
+    }
+
+    // The last worker of a stage closes the stream for the next stage
+    if (atomic_fetch_sub(&st->running, 1) == 1) stage_finished(p, st);
+    return NULL;
+}
+
+void pipeline_init(Pipeline* p) {
+    memset(p, 0, sizeof(*p));
+    atomic_init(&p->done, false);
+    atomic_init(&p->stopping, false);
+}
+
+static int add_stage(Pipeline* p, const char* name, StageKind kind, void* fn, void* ctx,
+                     int parallelism, int queue_capacity) {
+    if (p->num_stages == PIPELINE_MAX_STAGES) return -1;
+    if (parallelism < 1 || parallelism > PIPELINE_MAX_WORKERS) return -1;
+    if (kind != STAGE_SOURCE && queue_capacity < 1) return -1;
+    // A source comes first and only first; nothing follows the sink
+    if ((kind == STAGE_SOURCE) != (p->num_stages == 0)) return -1;
+    if (p->num_stages > 0 && p->stages[p->num_stages - 1].kind == STAGE_SINK) return -1;
+
+    PipeStage* st = &p->stages[p->num_stages];
+    st->owner = p;
+    st->index = p->num_stages++;
+    st->name = name;
+    st->kind = kind;
+    st->fn = fn;
+    st->ctx = ctx;
+    st->parallelism = parallelism;
+    st->queue_capacity = kind == STAGE_SOURCE ? 0 : queue_capacity;
+    return 0;
+}
+
+int pipeline_source(Pipeline* p, const char* name, PipeSourceFn fn, void* ctx, int parallelism) {
+    return add_stage(p, name, STAGE_SOURCE, (void*)fn, ctx, parallelism, 0);
+}
+
+int pipeline_transform(Pipeline* p, const char* name, PipeTransformFn fn, void* ctx,
+                       int parallelism, int queue_capacity) {
+    return add_stage(p, name, STAGE_TRANSFORM, (void*)fn, ctx, parallelism, queue_capacity);
+}
+
+int pipeline_sink(Pipeline* p, const char* name, PipeSinkFn fn, void* ctx,
+                  int parallelism, int queue_capacity) {
+    return add_stage(p, name, STAGE_SINK, (void*)fn, ctx, parallelism, queue_capacity);
+}
+
+// Stage i got only some of its workers and the stages before it none. The
+// stages after it are complete, so end the stream at stage i and let the
+// started workers drain out the way they do at the end of a run.
+static void abort_start(Pipeline* p, int i) {
+    PipeStage* st = &p->stages[i];
+    int missing = st->parallelism - st->started;
+
+    atomic_store(&p->stopping, true);
+    for (int t = 0; i > 0 && t < st->started; t++) {
+        queue_push(&p->queues[i], (PipeSlot){ NULL, true }, &p->stages[i - 1].wait_out_ns);
+    }
+    // Every worker may already be gone, then closing the stream is up to us
+    if (atomic_fetch_sub(&st->running, missing) == missing) stage_finished(p, st);
+
+    pipeline_wait(p);
+}
+
+int pipeline_start(Pipeline* p) {
+    if (p->num_stages < 2 || p->stages[p->num_stages - 1].kind != STAGE_SINK) return -1;
+
+    p->start_ns = now_ns();
+    for (int i = 1; i < p->num_stages; i++) {
+        PipeQueue* q = &p->queues[i];
+        q->capacity = p->stages[i].queue_capacity;
+        q->slots = calloc(q->capacity, sizeof(PipeSlot));
+        if (!q->slots) return -1;
+        //initialize semaphores
+        sem_init(&q->empty, 0, q->capacity);
+        sem_init(&q->full, 0, 0);
+        sem_init(&q->lock, 0, 1);
+        q->last_change_ns = p->start_ns;
+    }
+
+    // Sink first: a stage never runs ahead of a stage without workers
+    for (int i = p->num_stages - 1; i >= 0; i--) {
+        PipeStage* st = &p->stages[i];
+        atomic_store(&st->running, st->parallelism);
+        for (st->started = 0; st->started < st->parallelism; st->started++) {
+            if (pthread_create(&st->threads[st->started], NULL, stage_worker, st) != 0) {
+                abort_start(p, i);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+bool pipeline_done(Pipeline* p) {
+    return atomic_load(&p->done);
+}
+
+void pipeline_wait(Pipeline* p) {
+    for (int i = 0; i < p->num_stages; i++) {
+        for (int t = 0; t < p->stages[i].started; t++) {
+            pthread_join(p->stages[i].threads[t], NULL);
+        }
+        p->stages[i].started = 0;
+    }
+}
+
+void pipeline_destroy(Pipeline* p) {
+    for (int i = 1; i < p->num_stages; i++) {
+        PipeQueue* q = &p->queues[i];
+        if (!q->slots) continue;
+        sem_destroy(&q->empty);
+        sem_destroy(&q->full);
+        sem_destroy(&q->lock);
+        free(q->slots);
+        q->slots = NULL;
+    }
+}
+
+int pipeline_gauges(Pipeline* p, PipeGauge* out) {
+    uint64_t now = pipeline_done(p) ? p->end_ns : now_ns();
+    double elapsed = (now - p->start_ns) / 1e9;
+
+    for (int i = 0; i < p->num_stages; i++) {
+        PipeStage* st = &p->stages[i];
+        PipeGauge* g = &out[i];
+        double thread_ns = (double)(now - p->start_ns) * st->parallelism;
+
+        g->name = st->name;
+        g->parallelism = st->parallelism;
+        g->processed = atomic_load(&st->processed);
+        g->throughput = elapsed > 0 ? g->processed / elapsed : 0;
+        g->queue_depth = 0;
+        g->queue_capacity = st->queue_capacity;
+        g->occupancy = 0;
+        if (i > 0) {
+            PipeQueue* q = &p->queues[i];
+            sem_wait(&q->lock);
+            g->queue_depth = q->depth;
+            double integral = q->depth_ns + (double)q->depth * (now - q->last_change_ns);
+            sem_post(&q->lock);
+            if (now > p->start_ns) {
+                g->occupancy = integral / (now - p->start_ns) / q->capacity;
+            }
+        }
+        g->busy = thread_ns > 0 ? atomic_load(&st->busy_ns) / thread_ns : 0;
+        g->starved = thread_ns > 0 ? atomic_load(&st->wait_in_ns) / thread_ns : 0;
+        g->blocked = thread_ns > 0 ? atomic_load(&st->wait_out_ns) / thread_ns : 0;
+    }
+    return p->num_stages;
+}
+
+void pipeline_print_gauges(Pipeline* p, FILE* f) {
+    PipeGauge g[PIPELINE_MAX_STAGES];
+    int n = pipeline_gauges(p, g);
+    int bottleneck = 0;
+
+    fprintf(f, "%-10s %3s %10s %9s %9s %6s %6s %7s %7s\n",
+            "stage", "thr", "items", "items/s", "queue", "occ%", "busy%", "starv%", "block%");
+    for (int i = 0; i < n; i++) {
+        char queue[24] = "-";
+        if (i > 0) snprintf(queue, sizeof(queue), "%d/%d", g[i].queue_depth, g[i].queue_capacity);
+        fprintf(f, "%-10s %3d %10ld %9.0f %9s %6.1f %6.1f %7.1f %7.1f\n",
+                g[i].name, g[i].parallelism, g[i].processed, g[i].throughput, queue,
+                g[i].occupancy * 100, g[i].busy * 100, g[i].starved * 100, g[i].blocked * 100);
+        if (g[i].busy > g[bottleneck].busy) bottleneck = i;
+    }
+    fprintf(f, "bottleneck: %s (busy %.0f%% per thread; add threads there first)\n",
+            g[bottleneck].name, g[bottleneck].busy * 100);
+}
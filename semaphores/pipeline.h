@@ -0,0 +1,131 @@
+/*
+ * File: pipeline.h
+ * Multi-stage producer/consumer pipeline: source -> transform(s) -> sink.
+ *
+ * Every pair of neighbouring stages is joined by a bounded FIFO built the
+ * same way as producer_consumer.c (empty/full/lock semaphores), and every
+ * stage runs on its own number of threads. A full queue blocks the stage
+ * feeding it, so a slow sink throttles the source with no extra code.
+ *
+ *   Pipeline p;
+ *   pipeline_init(&p);
+ *   pipeline_source(&p, "read", read_fn, ctx, 1);
+ *   pipeline_transform(&p, "parse", parse_fn, ctx, 2, 64);
+ *   pipeline_sink(&p, "store", store_fn, ctx, 1, 64);
+ *   pipeline_start(&p);
+ *   while (!pipeline_done(&p)) { sleep(1); pipeline_print_gauges(&p, stdout); }
+ *   pipeline_wait(&p);
+ *   pipeline_destroy(&p);
+ *
+ * The last argument of transform/sink is the capacity of the queue in
+ * front of that stage. Items are opaque pointers owned by the callbacks;
+ * a stage with parallelism > 1 calls its callback from several threads.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#define PIPELINE_MAX_STAGES 8
+#define PIPELINE_MAX_WORKERS 64   // Threads per stage
+
+// Produce the next item; false at end of stream
+typedef bool (*PipeSourceFn)(void* ctx, void** item);
+// Turn in into *out; false drops the item
+typedef bool (*PipeTransformFn)(void* ctx, void* in, void** out);
+typedef void (*PipeSinkFn)(void* ctx, void* item);
+
+typedef enum { STAGE_SOURCE, STAGE_TRANSFORM, STAGE_SINK } StageKind;
+
+typedef struct {
+    void* item;
+    bool end;                    // End-of-stream marker, one per downstream worker
+} PipeSlot;
+
+// Bounded FIFO in front of a stage
+typedef struct {
+    PipeSlot* slots;
+    int capacity;
+    int head;
+    int depth;                   // Guarded by lock
+    sem_t empty;
+    sem_t full;
+    sem_t lock;
+    uint64_t last_change_ns;     // Guarded by lock, for the depth integral
+    uint64_t depth_ns;           // Integral of depth over time
+} PipeQueue;
+
+typedef struct Pipeline Pipeline;
+
+typedef struct {
+    Pipeline* owner;
+    int index;
+    const char* name;
+    StageKind kind;
+    void* fn;
+    void* ctx;
+    int parallelism;
+    int queue_capacity;
+    pthread_t threads[PIPELINE_MAX_WORKERS];
+    int started;                 // threads[0..started) exist and need a join
+    atomic_int running;          // Workers still going
+    atomic_long processed;       // Items taken in (items produced, for the source)
+    atomic_ulong busy_ns;        // Time inside the callback
+    atomic_ulong wait_in_ns;     // Blocked on an empty input queue (starved)
+    atomic_ulong wait_out_ns;    // Blocked on a full output queue (backpressure)
+} PipeStage;
+
+struct Pipeline {
+    PipeStage stages[PIPELINE_MAX_STAGES];
+    PipeQueue queues[PIPELINE_MAX_STAGES];   // queues[i] feeds stages[i], i >= 1
+    int num_stages;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    atomic_bool done;
+    atomic_bool stopping;        // Set when start fails: the source ends the stream
+};
+
+// Point-in-time reading of one stage and the queue in front of it
+typedef struct {
+    const char* name;
+    int parallelism;
+    long processed;
+    double throughput;           // Items per second since start
+    int queue_depth;             // Current items waiting (0 for the source)
+    int queue_capacity;
+    double occupancy;            // Time-averaged depth / capacity
+    double busy;                 // Share of the stage's thread time in the callback
+    double starved;              // ... blocked waiting for input
+    double blocked;              // ... blocked by a full output queue
+} PipeGauge;
+
+void pipeline_init(Pipeline* p);
+
+// Stages are appended in order; 0 on success, -1 if the pipeline is full,
+// the order is wrong or parallelism is out of range
+int pipeline_source(Pipeline* p, const char* name, PipeSourceFn fn, void* ctx, int parallelism);
+int pipeline_transform(Pipeline* p, const char* name, PipeTransformFn fn, void* ctx,
+                       int parallelism, int queue_capacity);
+int pipeline_sink(Pipeline* p, const char* name, PipeSinkFn fn, void* ctx,
+                  int parallelism, int queue_capacity);
+
+// Needs a source first and a sink last; 0 on success. -1 also if a worker
+// thread cannot be created, after the workers already started are wound
+// down and joined (pipeline_destroy is still needed)
+int pipeline_start(Pipeline* p);
+bool pipeline_done(Pipeline* p);
+void pipeline_wait(Pipeline* p);
+void pipeline_destroy(Pipeline* p);
+
+// Fills one gauge per stage (safe while running); returns the stage count
+int pipeline_gauges(Pipeline* p, PipeGauge* out);
+// Gauge table plus the bottleneck stage (busiest per thread)
+void pipeline_print_gauges(Pipeline* p, FILE* f);
+
+#endif
@@ -3,6 +3,15 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <semaphore.h>
+#include <time.h>
+#include <string.h>
+#include <stdatomic.h>
+//build: gcc -pthread producer_consumer.c pipeline.c -o producer_consumer
+//lock contention report: add -DLOCKPROF ../lockprof/lockprof.c (printed on Ctrl-C)
+//pipeline mode: ./producer_consumer -p [items] [enrich threads]
+//  four-stage ingest (read -> parse -> enrich -> store) with live gauges
+#include "pipeline.h"
+#include "../lockprof/lockprof.h"
 //initalize buffer & size & count
 int buffer[5];
 int count = 0;
@@ -46,9 +55,100 @@ void* consumer() {
     }
 }
 
-int main() {
+//---------------------------------------------------------------------------
+//pipeline mode: the same bounded buffer, chained between four stages
+//---------------------------------------------------------------------------
+
+typedef struct {
+    long id;
+    int value;
+    int score;
+} Record;
+
+typedef struct {
+    atomic_long next;
+    long total;
+} ReadCtx;
+
+bool read_record(void* ctx, void** item) {
+    ReadCtx* rc = ctx;
+    long id = atomic_fetch_add(&rc->next, 1);
+    if (id >= rc->total) return false;
+    
+    Record* r = malloc(sizeof(Record));
+    if (r == NULL) return false;
+    r->id = id;
+    r->value = rand() % 100;
+    *item = r;
+    return true;
+}
+
+bool parse_record(void* ctx, void* in, void** out) {
+    (void)ctx;
+    Record* r = in;
+    usleep(200); //cheap
+    *out = r;
+    return true;
+}
+
+bool enrich_record(void* ctx, void* in, void** out) {
+    (void)ctx;
+    Record* r = in;
+    usleep(2000); //slow lookup: the stage to scale out
+    r->score = r->value * 2;
+    *out = r;
+    return true;
+}
+
+void store_record(void* ctx, void* item) {
+    atomic_long* stored = ctx;
+    usleep(500);
+    atomic_fetch_add(stored, 1);
+    free(item);
+}
+
+int run_pipeline(long items, int enrichThreads) {
+    Pipeline p;
+    ReadCtx rc;
+    atomic_long stored;
+    
+    atomic_init(&rc.next, 0);
+    rc.total = items;
+    atomic_init(&stored, 0);
+    
+    pipeline_init(&p);
+    if (pipeline_source(&p, "read", read_record, &rc, 1) != 0 ||
+        pipeline_transform(&p, "parse", parse_record, NULL, 1, 16) != 0 ||
+        pipeline_transform(&p, "enrich", enrich_record, NULL, enrichThreads, 16) != 0 ||
+        pipeline_sink(&p, "store", store_record, &stored, 1, 16) != 0 ||
+        pipeline_start(&p) != 0) {
+        printf("Cannot build the pipeline\n");
+        pipeline_destroy(&p);
+        return 1;
+    }
+    
+    while (!pipeline_done(&p)) {
+        usleep(500000);
+        printf("\n");
+        pipeline_print_gauges(&p, stdout);
+    }
+    pipeline_wait(&p);
+    
+    printf("\nFinal (%ld of %ld records stored):\n", atomic_load(&stored), items);
+    pipeline_print_gauges(&p, stdout);
+    pipeline_destroy(&p);
+    return atomic_load(&stored) == items ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
     srand(time(NULL));
     
+    if (argc > 1 && strcmp(argv[1], "-p") == 0) {
+        long items = argc > 2 ? atol(argv[2]) : 2000;
+        int enrichThreads = argc > 3 ? atoi(argv[3]) : 1;
+        return run_pipeline(items, enrichThreads);
+    }
+    
     //initialize semaphores
     sem_init(&empty, 0, 5);
     sem_init(&full, 0, 0);
@@ -63,7 +163,7 @@ int main() {
     // Cleanup
     sem_destroy(&empty);
     sem_destroy(&full);
-    sem_destroy(&mutex);
+    sem_destroy(&lock);
     
     return 0;
 }
@@ -5,9 +5,19 @@
 #include <unistd.h>
 #include <semaphore.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+//build: gcc -pthread readerPriority.c reader_priority.c ../coro/coro.c -o readerPriority
+//lock contention report: add -DLOCKPROF ../lockprof/lockprof.c (printed on Ctrl-C)
+//coroutine mode: ./readerPriority -c [readers] [writers] [rounds] [workers]
+//  readers and writers run as stackless tasks on an M:N scheduler with a
+//  virtual clock, so the sleeps cost no real time and no thread per actor
+#include "../lockprof/lockprof.h"
+#include "../coro/coro.h"
+#include "reader_priority.h"
 
-sem_t x, wsem;
-int readCount = 0;
+ReaderPriority rp;  //the protocol, shared with the benchmarks
 
 void READUNIT(int index){
   printf("Reader #%d is reading\n", index);
@@ -24,21 +34,9 @@ void WRITEUNIT(int index){
 void* reader(void* arg){
   int index = *(int*)arg;
   while(true){
-    sem_wait(&x);
-    readCount++;
-    if(readCount == 1){
-      sem_wait(&wsem);
-    }
-    sem_post(&x);
-    
+    reader_enter(&rp);
     READUNIT(index);
-    
-    sem_wait(&x);
-    readCount--;
-    if(readCount == 0){
-      sem_post(&wsem);
-    }
-    sem_post(&x);
+    reader_exit(&rp);
     
     sleep(1); // Small delay between iterations
   }
@@ -48,22 +46,143 @@ void* reader(void* arg){
 void* writer(void* arg){
   int index = *(int*)arg;
   while(true){
-    sem_wait(&wsem);
+    writer_enter(&rp);
     WRITEUNIT(index);
-    sem_post(&wsem);
+    writer_exit(&rp);
     
     sleep(1); // Small delay between iterations
   }
   return NULL;
 }
 
-int main(){
+//---------------------------------------------------------------------------
+//coroutine version: same protocol on CoSems, sleeps suspend the task
+//---------------------------------------------------------------------------
+
+#define SEC 1000000000ull
+
+CoSem cx, cwsem;
+int coReadCount = 0;  //guarded by cx
+int coRounds = 3;
+bool coVerbose = true;
+long coReads = 0;     //guarded by cx
+long coWrites = 0;    //guarded by cwsem
+
+typedef struct {
+  CoTask task;        //must come first
+  int index;
+  int round;
+} Actor;
+
+int reader_step(CoTask* t){
+  Actor* a = (Actor*)t;
+  CO_BEGIN(t);
+  for(a->round = 0; a->round < coRounds; a->round++){
+    CO_SEM_WAIT(t, &cx);
+    coReadCount++;
+    if(coReadCount == 1){
+      CO_SEM_WAIT(t, &cwsem);
+    }
+    co_sem_post(&cx);
+    
+    if(coVerbose) printf("Reader #%d is reading\n", a->index);
+    CO_SLEEP(t, 10 * SEC);
+    if(coVerbose) printf("Reader #%d finished\n", a->index);
+    
+    CO_SEM_WAIT(t, &cx);
+    coReadCount--;
+    coReads++;
+    if(coReadCount == 0){
+      co_sem_post(&cwsem);
+    }
+    co_sem_post(&cx);
+    
+    CO_SLEEP(t, 1 * SEC); // Small delay between iterations
+  }
+  CO_END(t);
+}
+
+int writer_step(CoTask* t){
+  Actor* a = (Actor*)t;
+  CO_BEGIN(t);
+  for(a->round = 0; a->round < coRounds; a->round++){
+    CO_SEM_WAIT(t, &cwsem);
+    if(coVerbose) printf("Writer #%d is writing\n", a->index);
+    CO_SLEEP(t, 5 * SEC);
+    if(coVerbose) printf("Writer #%d finished\n", a->index);
+    coWrites++;
+    co_sem_post(&cwsem);
+    
+    CO_SLEEP(t, 1 * SEC); // Small delay between iterations
+  }
+  CO_END(t);
+}
+
+int run_coroutines(int numReaders, int numWriters, int workers){
+  CoScheduler sched;
+  Actor* actors = calloc(numReaders + numWriters, sizeof(Actor));
+  struct timespec start, end;
+  
+  if(actors == NULL){
+    printf("Cannot allocate %d actors\n", numReaders + numWriters);
+    return 1;
+  }
+  coVerbose = numReaders + numWriters <= 20;
+  co_sem_init(&cx, 1);
+  co_sem_init(&cwsem, 1);
+  co_sched_init(&sched, workers, true);
+  
+  //interleave like the thread version: writer i, then reader i
+  int i;
+  for(i = 0; i < numReaders || i < numWriters; i++){
+    if(i < numWriters){
+      actors[numReaders + i].index = i + 1;
+      co_spawn(&sched, &actors[numReaders + i].task, writer_step);
+    }
+    if(i < numReaders){
+      actors[i].index = i + 1;
+      co_spawn(&sched, &actors[i].task, reader_step);
+    }
+  }
+  
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int rc = co_sched_run(&sched);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  
+  double wall = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+  printf("\n%d readers + %d writers as tasks on %d threads, %zu bytes each (%.1f MB)\n",
+         numReaders, numWriters, sched.workers, sizeof(Actor),
+         (numReaders + numWriters) * sizeof(Actor) / 1e6);
+  printf("%ld reads, %ld writes, %lu task steps\n", coReads, coWrites, sched.steps);
+  printf("simulated %.0f s in %.1f ms\n", co_now(&sched) / 1e9, wall);
+  if(rc != 0){
+    printf("deadlock: tasks left with nothing runnable\n");
+  }
+  
+  co_sched_destroy(&sched);
+  co_sem_destroy(&cx);
+  co_sem_destroy(&cwsem);
+  free(actors);
+  return rc == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv){
+  if(argc > 1 && strcmp(argv[1], "-c") == 0){
+    int numReaders = argc > 2 ? atoi(argv[2]) : 10;
+    int numWriters = argc > 3 ? atoi(argv[3]) : 10;
+    if(argc > 4) coRounds = atoi(argv[4]);
+    int workers = argc > 5 ? atoi(argv[5]) : 4;
+    return run_coroutines(numReaders, numWriters, workers);
+  }
+  
   pthread_t readers[10];
   pthread_t writers[10];
   int ids[10];
   
-  sem_init(&x, 0, 1);
-  sem_init(&wsem, 0, 1);
+  if(reader_priority_init(&rp) != 0){
+    printf("Cannot create the reader/writer semaphores\n");
+    return 1;
+  }
   
   int i;
   for(i = 0; i < 10; i++){
@@ -77,8 +196,7 @@ int main(){
     pthread_join(writers[i], NULL);
   }
   
-  sem_destroy(&x);
-  sem_destroy(&wsem);
+  reader_priority_destroy(&rp);
   
   return 0;
 }
@@ -0,0 +1,50 @@
+/*
+ * File: reader_priority.c
+ * Readers-priority readers/writer lock.
+ */
+
+#include <pthread.h>
+#include <semaphore.h>
+#include "reader_priority.h"
+#include "../lockprof/lockprof.h"
+
+int reader_priority_init(ReaderPriority* rp) {
+    rp->read_count = 0;
+    if (sem_init(&rp->x, 0, 1) != 0) return -1;
+    if (sem_init(&rp->wsem, 0, 1) != 0) {
+        sem_destroy(&rp->x);
+        return -1;
+    }
+    return 0;
+}
+
+void reader_priority_destroy(ReaderPriority* rp) {
+    sem_destroy(&rp->x);
+    sem_destroy(&rp->wsem);
+}
+
+void reader_enter(ReaderPriority* rp) {
+    sem_wait(&rp->x);
+    rp->read_count++;
+    if (rp->read_count == 1) {
+        sem_wait(&rp->wsem);
+    }
+    sem_post(&rp->x);
+}
+
+void reader_exit(ReaderPriority* rp) {
+    sem_wait(&rp->x);
+    rp->read_count--;
+    if (rp->read_count == 0) {
+        sem_post(&rp->wsem);
+    }
+    sem_post(&rp->x);
+}
+
+void writer_enter(ReaderPriority* rp) {
+    sem_wait(&rp->wsem);
+}
+
+void writer_exit(ReaderPriority* rp) {
+    sem_post(&rp->wsem);
+}
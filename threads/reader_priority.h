@@ -0,0 +1,31 @@
+/*
+ * File: reader_priority.h
+ * Readers-priority readers/writer lock from two semaphores.
+ *
+ * The first reader in takes wsem for the whole group of readers and the
+ * last one out gives it back, so a writer waits while any reader is
+ * inside; x guards the reader count. Shared by readerPriority.c and the
+ * benchmarks, so both measure the same protocol.
+ */
+
+#ifndef READER_PRIORITY_H
+#define READER_PRIORITY_H
+
+#include <semaphore.h>
+
+typedef struct {
+    sem_t x;            // Guards read_count
+    sem_t wsem;         // Held by a writer, or by the readers as a group
+    int read_count;
+} ReaderPriority;
+
+// Returns 0, or -1 if a semaphore cannot be created
+int reader_priority_init(ReaderPriority* rp);
+void reader_priority_destroy(ReaderPriority* rp);
+
+void reader_enter(ReaderPriority* rp);
+void reader_exit(ReaderPriority* rp);
+void writer_enter(ReaderPriority* rp);
+void writer_exit(ReaderPriority* rp);
+
+#endif